@@ -0,0 +1,223 @@
+#ifndef ALIASSAMPLER_H
+#define ALIASSAMPLER_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+/*
+    Constant time sampling of the input histograms with the alias method (Walker, Vose).
+
+    The N bins are the columns of a table: a draw picks a column uniformly and keeps it with the probability
+    threshold of the column, otherwise it takes the alias bin of the column. The table is built once in O(N) with
+    the construction of Vose and is only read afterwards, so a single table can be shared by all the worker
+    threads. Inside the selected bin the value is uniform, as in TH1::GetRandom and TH2::GetRandom2. The bins of a
+    2D histogram are the columns of a single table, flattened as x + nX * y.
+*/
+
+#include<TH1.h>
+#include<vector>
+
+/// @brief Column of an alias table
+typedef struct {
+    Double_t threshold;     //Probability of keeping the column bin
+    UInt_t alias;           //Bin selected otherwise
+    } AliasColumn;
+
+/// @brief Alias table of the bins of a 1D histogram (under/overflow excluded)
+typedef struct {
+    std::vector<AliasColumn> columns;
+    std::vector<Double_t> lowEdge;  //Lower edge of each bin
+    std::vector<Double_t> width;    //Width of each bin
+    } HistogramSampler;
+
+/// @brief Alias table of the bins of a 2D histogram (under/overflow excluded)
+typedef struct {
+    std::vector<AliasColumn> columns;   //Flattened bin index x + nX * y
+    UInt_t nX;
+    std::vector<Double_t> xLowEdge;
+    std::vector<Double_t> xWidth;
+    std::vector<Double_t> yLowEdge;
+    std::vector<Double_t> yWidth;
+    } Histogram2DSampler;
+
+namespace AliasSampler
+{
+    /// @brief Builds the alias table of a set of non negative weights (the negative ones are treated as zero)
+    /// @return False if all the weights are zero, the table is empty
+    inline bool BuildTable(const std::vector<Double_t> &weights, std::vector<AliasColumn> &columns)
+    {
+        UInt_t n = weights.size();
+        columns.assign(n, AliasColumn{1., 0});
+
+        Double_t sum = 0.;
+        for (Double_t w : weights)
+            if (w > 0) sum += w;
+        if (!(sum > 0))
+        {
+            columns.clear();
+            return false;
+        }
+
+        //Weights scaled to a mean of 1, the columns below and above the mean are paired
+        std::vector<Double_t> scaled(n);
+        std::vector<UInt_t> small, large;
+        for (UInt_t i = 0; i < n; ++i)
+        {
+            scaled[i] = (weights[i] > 0) ? weights[i] * n / sum : 0.;
+            columns[i].alias = i;
+            if (scaled[i] < 1.) small.push_back(i);
+            else large.push_back(i);
+        }
+
+        while (!small.empty() && !large.empty())
+        {
+            UInt_t s = small.back();
+            UInt_t l = large.back();
+            small.pop_back();
+
+            //Column s is filled up to 1 with the bin l
+            columns[s].threshold = scaled[s];
+            columns[s].alias = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.;
+
+            if (scaled[l] < 1.)
+            {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        //Columns left over by the rounding errors are full
+        for (UInt_t i : large) columns[i].threshold = 1.;
+        for (UInt_t i : small) columns[i].threshold = 1.;
+        return true;
+    }
+
+    /// @brief Index of a column selected with a single uniform number u in (0, 1): the integer part of u N picks the column, the fractional part decides between the column and its alias
+    inline UInt_t SampleIndex(const std::vector<AliasColumn> &columns, Double_t u)
+    {
+        UInt_t n = columns.size();
+        Double_t x = u * n;
+        UInt_t k = (UInt_t)x;
+        if (k >= n) k = n - 1;
+        const AliasColumn &column = columns[k];
+        return (x - k < column.threshold) ? k : column.alias;
+    }
+
+    /// @brief Builds the sampler of the bins 1..N of a 1D histogram
+    /// @return False if the histogram is missing or empty, the sampler then returns 0 as TH1::GetRandom
+    inline bool Build(const TH1 * h, HistogramSampler &sampler)
+    {
+        sampler.columns.clear();
+        sampler.lowEdge.clear();
+        sampler.width.clear();
+        if (h == nullptr) return false;
+
+        Int_t nBins = h->GetNbinsX();
+        std::vector<Double_t> weights(nBins);
+        sampler.lowEdge.resize(nBins);
+        sampler.width.resize(nBins);
+        for (Int_t i = 0; i < nBins; ++i)
+        {
+            weights[i] = h->GetBinContent(i + 1);
+            sampler.lowEdge[i] = h->GetXaxis()->GetBinLowEdge(i + 1);
+            sampler.width[i] = h->GetXaxis()->GetBinWidth(i + 1);
+        }
+
+        return BuildTable(weights, sampler.columns);
+    }
+
+    /// @brief Random value distributed as the histogram, uniform inside each bin. Two uniform numbers per call.
+    /// @param rnd Random engine (TRandom) or RandomBuffer
+    template<typename Random>
+    inline Double_t Sample(const HistogramSampler &sampler, Random * rnd)
+    {
+        if (sampler.columns.empty()) return 0.;
+
+        UInt_t bin = SampleIndex(sampler.columns, rnd->Rndm());
+        return sampler.lowEdge[bin] + sampler.width[bin] * rnd->Rndm();
+    }
+
+    /// @brief Fills an array with random values distributed as the histogram, with the uniform numbers drawn in bulk
+    /// @param rnd Random engine with RndmArray
+    template<typename Random>
+    inline void SampleArray(const HistogramSampler &sampler, unsigned int n, Double_t * out, Random * rnd)
+    {
+        if (sampler.columns.empty())
+        {
+            for (unsigned int i = 0; i < n; ++i) out[i] = 0.;
+            return;
+        }
+
+        const unsigned int kChunk = 32;
+        Double_t u[2 * kChunk];
+        for (unsigned int first = 0; first < n; first += kChunk)
+        {
+            unsigned int m = (n - first < kChunk) ? n - first : kChunk;
+            rnd->RndmArray(2 * m, u);
+            for (unsigned int k = 0; k < m; ++k)
+            {
+                UInt_t bin = SampleIndex(sampler.columns, u[2 * k]);
+                out[first + k] = sampler.lowEdge[bin] + sampler.width[bin] * u[2 * k + 1];
+            }
+        }
+    }
+
+    /// @brief Builds the sampler of the bins (1..NX, 1..NY) of a 2D histogram
+    /// @return False if the histogram is missing or empty, the sampler then returns (0, 0) as TH2::GetRandom2
+    inline bool Build2D(const TH1 * h, Histogram2DSampler &sampler)
+    {
+        sampler.columns.clear();
+        sampler.nX = 0;
+        if (h == nullptr) return false;
+
+        Int_t nX = h->GetNbinsX();
+        Int_t nY = h->GetNbinsY();
+        sampler.nX = nX;
+        sampler.xLowEdge.resize(nX);
+        sampler.xWidth.resize(nX);
+        sampler.yLowEdge.resize(nY);
+        sampler.yWidth.resize(nY);
+        for (Int_t i = 0; i < nX; ++i)
+        {
+            sampler.xLowEdge[i] = h->GetXaxis()->GetBinLowEdge(i + 1);
+            sampler.xWidth[i] = h->GetXaxis()->GetBinWidth(i + 1);
+        }
+        for (Int_t j = 0; j < nY; ++j)
+        {
+            sampler.yLowEdge[j] = h->GetYaxis()->GetBinLowEdge(j + 1);
+            sampler.yWidth[j] = h->GetYaxis()->GetBinWidth(j + 1);
+        }
+
+        std::vector<Double_t> weights(nX * nY);
+        for (Int_t j = 0; j < nY; ++j)
+            for (Int_t i = 0; i < nX; ++i)
+                weights[i + nX * j] = h->GetBinContent(i + 1, j + 1);
+
+        return BuildTable(weights, sampler.columns);
+    }
+
+    /// @brief Random point distributed as the 2D histogram, uniform inside each bin. Three uniform numbers per call.
+    template<typename Random>
+    inline void Sample2D(const Histogram2DSampler &sampler, Double_t &x, Double_t &y, Random * rnd)
+    {
+        if (sampler.columns.empty())
+        {
+            x = 0.;
+            y = 0.;
+            return;
+        }
+
+        UInt_t bin = SampleIndex(sampler.columns, rnd->Rndm());
+        UInt_t i = bin % sampler.nX;
+        UInt_t j = bin / sampler.nX;
+        x = sampler.xLowEdge[i] + sampler.xWidth[i] * rnd->Rndm();
+        y = sampler.yLowEdge[j] + sampler.yWidth[j] * rnd->Rndm();
+    }
+}
+
+#endif
@@ -15,6 +15,7 @@
 #include "TNamed.h"
 
 #include "../inc/runManager.h"
+#include "../inc/fastMath.h"
 
 class CalculateDeltaPhiMax : public TNamed
 {
@@ -9,6 +9,8 @@
 */
 
 #include<string>
+#include<map>
+#include<tuple>
 
 #include<TObject.h>
 #include<TFile.h>
@@ -18,6 +20,7 @@
 #include "../inc/runManager.h"
 #include "../inc/eventDisplay.h"
 #include "../inc/vertexReco.h"
+#include "../inc/shardMerger.h"
 
 class Cli
 {
@@ -31,12 +34,24 @@ class Cli
         static EventDisplay * DrawEvent(RunManager * rm, unsigned long int eventID);
         static EventDisplay * DrawEvent(unsigned long int eventID);
 
+        /// @brief Splits the run described in the configuration file over nShards local processes, each one simulating a disjoint range of event IDs, and then merges their output files
+        static bool ShardedSimulation(TString configurationFilePath, unsigned int nShards);
+        static bool MergeShards(TString configurationFilePath, unsigned int nShards);
+
+        /// @brief Simulates the run described in the configuration file twice, with the double and with the single precision transport (start.cxx option "float"), and compares the hits of the two runs
+        static bool ComparePrecision(TString configurationFilePath);
+
+        /// @brief Residuals between the hits of two simulation output files, matched by eventID, particleID and detectorID. Noise hits (particleID = 0) are not compared.
+        static bool CompareHits(TString referenceFileName, TString testFileName);
+
         static ProgramConfig * conf;
         static RunManager * currentRun;
 
     private:
         static bool currentRunAllocated;
         static bool configAllocated;
+        static unsigned int shardIndex;
+        static unsigned int nShards;
 };
 
 //Definition of static data members
@@ -44,5 +59,7 @@ ProgramConfig * Cli::conf;
 RunManager * Cli::currentRun;
 bool Cli::currentRunAllocated;
 bool Cli::configAllocated;
+unsigned int Cli::shardIndex = 0;
+unsigned int Cli::nShards = 1;
 
 #endif
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include<fstream>
 #include<string>
 #include<sstream>
+#include<vector>
 
 #include<TObject.h>
 #include<TFile.h>
@@ -21,6 +22,38 @@
 #include<TF2.h>
 
 #include "../inc/units.h"
+#include "../inc/inputDistribution.h"
+
+/// @brief One cylindrical layer of the barrel geometry
+typedef struct {
+    Double_t radius;        //Mean radius
+    Double_t thickness;
+    Double_t length;
+    std::string material;   //Vacuum, Berillium or Silicon
+    bool sensitive;         //Only the hits on sensitive layers are recorded in the TTree
+    unsigned int nPhiModules;   //Segmentation in pixel modules, 0 for a continuous layer
+    unsigned int nZModules;
+    Double_t moduleWidth;       //Width of a module in the r-phi plane
+    Double_t moduleLength;      //Length of a module along the beam axis
+    } LayerConfig;
+
+/// @brief Input distributions of the simulation, see InputDistribution
+typedef struct {
+    Distribution1D collisionPerEvent;
+    Distribution1D momentum;
+    Distribution1D eta;
+    Distribution1D multiplicity;
+    Distribution1D phi;
+    Distribution1D bunchCrossingX;
+    Distribution1D bunchCrossingY;
+    Distribution1D zPos;
+    Distribution1D innerCounts;
+    Distribution1D outerCounts;
+    Distribution1D pixelActivationCount;
+    Distribution2D innerSiliconNoise;
+    Distribution2D outerSiliconNoise;
+    Distribution2D pixelActivationMap;
+    } InputSamplers;
 
 /// @brief This class handles the simulation / reconstruction / analysis configuration
 class ProgramConfig : public TObject
@@ -34,6 +67,13 @@ class ProgramConfig : public TObject
         bool IsInit();
         void SetFilename(std::string filename);
         void SetRecord(std::string key, std::string value);
+        void AddLayer(std::string value);
+
+        /// @brief Builds the alias samplers of the input histograms. It must be called at the beginning of the run, after the last change of the input distributions.
+        void PrepareSampling();
+
+        /// @brief Input distributions, parametric or sampled from the histograms with the tables built by PrepareSampling. They are only read during the run (shared by all the worker threads).
+        InputSamplers samplers; //!
 
         //Run configuration
         std::string simRootFileName = "./simulationOutput.root";
@@ -42,6 +82,22 @@ class ProgramConfig : public TObject
         unsigned long int eventNumber = 200;
         unsigned long int reportEvery = 15;
         int rndSeed = 234;
+        unsigned int nThreads = 1;
+        bool counterBasedRandom = false;
+        unsigned int pipelineStages = 0;
+        bool asyncOutput = true;
+        unsigned int transportBatchSize = 1;
+
+        //Sharding of a single logical run over several processes
+        unsigned int nShards = 1;
+        unsigned int shardIndex = 0;
+
+        /// @brief Select the part of the run simulated by this process. Shard k of N simulates a contiguous range of event IDs, uses its own seed and writes its own file.
+        void SetShard(unsigned int index, unsigned int total);
+        unsigned long int GetShardFirstEvent();
+        unsigned long int GetShardEventNumber();
+        int GetShardSeed();
+        std::string GetShardFileName(unsigned int index);
         bool singleCollisionInEvent = true;
         bool singleEventPersistenceEnabled = false;
         bool hitDebugMode = true;
@@ -66,8 +122,8 @@ class ProgramConfig : public TObject
         TH2D * pixelActivationMap = nullptr; //!
         TH1D * pixelActivationCount = nullptr; //!
 
-        double mass = 511*keV/(c*c);
-        double charge = -1 * e;
+        double mass = 511*Units::keV/(Units::c*Units::c);
+        double charge = -1 * Units::e;
 
         void OpenInputTFile(std::string path);
         void WriteInputTFile(std::string path);
@@ -75,6 +131,12 @@ class ProgramConfig : public TObject
         bool enableHitGaussianSmearing;
         bool enableSoftParticlesNoise;
         bool disableKin = false;
+        bool highlandMultipleScattering = false; //Highland formula with the material of each layer instead of the fixed 1 mrad scattering angle
+
+        //Geometric acceptance prefilter of the primary particles, see ParticleGun::InAcceptance
+        bool acceptancePrefilter = false;       //Primaries of non persistent events that cannot reach a sensitive layer are not transported
+        Double_t acceptanceMargin = 0.05;       //Polar angle margin (rad) for the deflection of the multiple scattering
+        bool acceptanceTruthCount = false;      //Count the rejected primaries and report them at the end of the run
 
         //Geometry
         Double_t beamPipeRadius;
@@ -86,10 +148,13 @@ class ProgramConfig : public TObject
         Double_t innerSiLenght;
         Double_t outerSiLenght;
 
+        /// @brief Layers of the barrel, from the "layer=radius,thickness,length,material,sensitive[,nPhiModules,nZModules,moduleWidth,moduleLength]" keys of the configuration file (one per layer, the layer index is the detectorID of its hits). Without layer keys the geometry is the beam pipe and the two silicon layers described by the parameters above. The list is built by ReadConfigurationFile and LoadDebugData, it is only read during the run.
+        const std::vector<LayerConfig> &GetLayers() const {return layers;}
+
         //Reconstruction parameters
         bool enableDeltaPhiMaxCalculation = true;
         std::string outRecoRootFileName = "./recoOutput.root";
-        Double_t runningWindowSize = 5 *mm;
+        Double_t runningWindowSize = 5 *Units::mm;
         Double_t runningWPercentStep = 0.2;
         int minVertNumber = 1;
         Double_t limitPercMaxNumVert = 1.;
@@ -106,12 +171,22 @@ class ProgramConfig : public TObject
         std::string confFilename = "";
         bool init = false;
         bool inputFileInitialized = false;
+        std::vector<LayerConfig> layerKeys; //! Layers of the "layer" keys
+        std::vector<LayerConfig> layers; //! Geometry of the run, see GetLayers
+
+        /// @brief Sets the geometry of the run: the layer keys if any, otherwise the legacy beam pipe and silicon layers
+        void BuildLayers();
 
         TH1D * ReadTH1D(std::string key); //!
         TF1  * ReadTF1(std::string key); //!
         TH2D * ReadTH2D(std::string key); //!
         TF2  * ReadTF2(std::string key); //!
 
+        /// @brief Reads the parametric definition of an input distribution, e.g. "gaus(0,4)" (see InputDistribution)
+        /// @return False if the value is not a valid parametric definition: the distribution is then a histogram and the value is read as its name in the input file
+        bool SetParametric(std::string value, Distribution1D &distribution);
+        bool SetParametric(std::string value, Distribution2D &distribution);
+
 };
 
 
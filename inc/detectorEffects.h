@@ -35,14 +35,11 @@ class DetectorEffects : public TNamed
         void SoftParticlePixelNoise(EventManager * event);
 
     private:
-        static RndEngine * rndEngine;
+        RndEngine * rndEngine;
         ProgramConfig * conf;
         
 
     //ClassDef(DetectorEffects, 1);
 };
 
-//Definition of static data members
-RndEngine * DetectorEffects::rndEngine;
-
 #endif
@@ -0,0 +1,79 @@
+#ifndef EVENTARENA_H
+#define EVENTARENA_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<vector>
+#include<mutex>
+#include<cstddef>
+#include<new>
+#include<utility>
+#include<type_traits>
+
+/// @brief Bump allocator for the Track and Hit objects of one event. The memory is taken from fixed size chunks, recycled through a cache shared by all the arenas, and it is released all at once by Reset(), which runs the destructors of the objects (in reverse order of construction) before recycling the memory.
+class EventArena
+{
+    public:
+        EventArena() {}
+        ~EventArena();
+
+        EventArena(const EventArena &) = delete;
+        EventArena &operator=(const EventArena &) = delete;
+
+        /// @brief Constructs an object of type T inside the arena
+        template<class T, class... Args>
+        T * New(Args&&... args)
+        {
+            T * object = new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+            if (!std::is_trivially_destructible<T>::value)
+                destructors.push_back({object, &Destroy<T>});
+            return object;
+        }
+
+        /// @brief Destroys and releases all the objects at once. The first chunk is kept for the next event, the others go back to the shared cache.
+        void Reset();
+
+    private:
+        static const std::size_t kChunkSize = 64 * 1024;
+        static const std::size_t kAlignment = alignof(std::max_align_t);
+        static const std::size_t kMaxCachedChunks = 1024;
+
+        std::vector<char *> chunks;
+        std::size_t offset = kChunkSize; //Offset of the first free byte in the last chunk
+
+        //Objects with a non trivial destructor (e.g. the TObject ones, which unregister themselves from ROOT)
+        typedef struct {
+            void * object;
+            void (*destroy)(void *);
+            } Destructor;
+        std::vector<Destructor> destructors;
+
+        template<class T>
+        static void Destroy(void * object) {static_cast<T *>(object)->~T();}
+
+        void DestroyObjects();
+
+        void * Allocate(std::size_t size)
+        {
+            size = (size + kAlignment - 1) & ~(kAlignment - 1);
+            if (offset + size > kChunkSize) NewChunk(size);
+            void * object = chunks.back() + offset;
+            offset += size;
+            return object;
+        }
+
+        void NewChunk(std::size_t size);
+
+        //Chunks released by the arenas, shared among the worker threads
+        static std::mutex cacheMutex;
+        static std::vector<char *> chunkCache;
+        static char * AcquireChunk();
+        static void   ReleaseChunk(char * chunk);
+};
+
+#endif
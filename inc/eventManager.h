@@ -8,11 +8,16 @@
 *   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
 */
 
+#include<atomic>
+
 #include<TObject.h>
 #include<TVector3.h>
 
 #include "../inc/track.h"
 #include "../inc/hit.h"
+#include "../inc/eventRecord.h"
+#include "../inc/eventArena.h"
+#include "../inc/trackState.h"
 #include "../inc/runManager.h"
 
 /// @brief The eventManager is the class representing a single event, it is a container that stores all the tracks
@@ -20,6 +25,7 @@ class EventManager : public TObject
 {
     public:
         EventManager();
+        EventManager(Int_t eventIdentifier);
         EventManager(const EventManager &eventSource);
         ~EventManager(); //UNALLOCATE ALL THE CONTENT IN hits AND tracks
 
@@ -37,10 +43,17 @@ class EventManager : public TObject
         /// @brief Invokes the deallocation from memory of all the Tracks and Hits objects (only data inside the TTree survives) and then the std::vectors holding the pointers are erased
         void CleanupEvent();
 
+        /// @brief Allocate a Track or a Hit of this event in the event arena, released in one step by CleanupEvent. Only the persistent events build Track and Hit objects, the others are transported as TrackStates.
+        Track * NewTrack();
+        Track * NewTrack(unsigned long int particleID);
+        Hit   * NewHit();
+
         std::vector<Track *> tracks; //!
         std::vector<Track *> inactiveTracks; //!
         std::vector<Hit *> hits; //!
+        std::vector<TrackState> trackStates; //! Particles of non persistent events, used instead of tracks
         RunManager * runManager; //!
+        EventRecord record; //!
 
         void SetVertex(Double_t vx, Double_t vy, Double_t vz) {vertX = vx; vertY = vy; vertZ = vz;}
         Double_t GetVertX() {return vertX;}
@@ -49,8 +62,9 @@ class EventManager : public TObject
 
     private:
         Int_t eventID;
-        bool persist;
-        static long int eventIDCounter;
+        bool persist = false;
+        EventArena arena; //!
+        static std::atomic<long int> eventIDCounter; //!
         Double_t vertX, vertY, vertZ;
 
         static long int GenerateEventID();
@@ -59,7 +73,7 @@ class EventManager : public TObject
 };
 
 //Definition of static data members
-long int EventManager::eventIDCounter;
+std::atomic<long int> EventManager::eventIDCounter(0);
 
 //Directives for dictionary generation by ROOTCLING for ACliC
 #ifdef __ROOTCLING__
@@ -0,0 +1,40 @@
+#ifndef EVENTRECORD_H
+#define EVENTRECORD_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<vector>
+
+#include<TObject.h>
+
+typedef struct{
+    Double_t X;
+    Double_t Y;
+    Double_t Z;
+    Int_t mult;
+    Int_t eventID;
+    } Vertex;
+
+typedef struct{
+    Double_t X;
+    Double_t Y;
+    Double_t Z;
+    ULong64_t eventID;
+    ULong64_t particleID;
+    ULong64_t detectorID;
+    } DetHit;
+
+/// @brief Output of a single event, as it will be written in the PixelTracker TTree. The simulation classes only append to the record of the event they are processing, and the RunManager copies it into the branches in a single step, so that the event can be simulated on any thread.
+typedef struct{
+    std::vector<Vertex> vertices;
+    std::vector<DetHit> detHits;
+    ULong64_t primaries = 0;            //Primary particles of the event
+    ULong64_t rejectedPrimaries = 0;    //Primaries outside the acceptance, not transported (ParticleGun::InAcceptance)
+    } EventRecord;
+
+#endif
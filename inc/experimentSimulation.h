@@ -25,6 +25,10 @@
 #include "../inc/track.h"
 #include "../inc/hit.h"
 #include "../inc/conf.h"
+#include "../inc/trackBatch.h"
+#include "../inc/intersectionKernel.h"
+#include "../inc/moduleGrid.h"
+#include "../inc/fastMath.h"
 
 /// @brief Setting the data members of this struct the user can enable or disable specific functions modeling radiation-matter interaction effects
 typedef struct PhysicsListTypedef {
@@ -33,6 +37,16 @@ typedef struct PhysicsListTypedef {
     bool betheblochIonization = false; //Possible future upgrade, compatible with the software architecture, but not yet implemented!
     } PhysicsList;
 
+/// @brief Options of PhysicsList and ProgramConfig compiled in the specialized transport of the non persistent events
+namespace PhysicsPolicy
+{
+    const unsigned int kMultipleScattering  = 1;    //PhysicsList::multipleScattering
+    const unsigned int kHighland            = 2;    //!PhysicsList::multipleScatteringThetaMsApprox
+    const unsigned int kKinematics          = 4;    //!ProgramConfig::disableKin
+    const unsigned int kSmearing            = 8;    //ProgramConfig::enableHitGaussianSmearing
+    const unsigned int kAll                 = 15;
+}
+
 /// @brief This class describes this specific simulation, its geometry and it acts on the information stored inside each eventManager. It uses the physics tools (as static methods) from the TransportEngine class.
 class ExperimentSimulation : public TNamed
 {
@@ -48,8 +62,15 @@ class ExperimentSimulation : public TNamed
 
         void ProcessEvent(EventManager * currentEvent);
 
+        /// @brief Transports the particles of a block of non persistent events together. The active TrackStates are gathered in a TrackBatch and each step (intersection with the next layer, hit, multiple scattering) is done for the whole block before the next one.
+        /// @param events Events of the block, their hits are added to the EventRecord of each event
+        void ProcessEventBatch(std::vector<EventManager *> &events);
+
         PhysicsList physicsList;
 
+        /// @brief Selects the transport specialized on the current physicsList and configuration options, so that the disabled physics is not tested per particle or per hit. It is called by the RunManager at the beginning of the run (and by the first ProcessEvent otherwise): later changes of the options require a new call.
+        void SelectTransport();
+
     private:
         RunManager * tree;
         TGeoManager  * worldVolume;
@@ -58,23 +79,56 @@ class ExperimentSimulation : public TNamed
         TGeoMaterial * berillium;
         TGeoMaterial * silicon;
 
-        TGeoTube     * beamPipe;
-        TGeoTube     * innerSiPlane;
-        TGeoTube     * outerSiPlane;
+        std::vector<TGeoTube *> geometryRegister;       //Layers in the order of the configuration, the index is the detectorID
+        std::vector<TGeoMaterial *> materialRegister;   //Material of each layer of geometryRegister
+        LayerTable layerTable; //Layers of geometryRegister sorted by radius, read by the transport
+        std::vector<ModuleLayout> moduleGrid;           //Pixel modules of each layer of geometryRegister
+        std::vector<Double_t> highlandConstant;         //Multiple scattering constant of each layer of layerTable, see TransportEngine::HighlandConstant
 
-        std::vector<TGeoTube *> geometryRegister;
+        TGeoMaterial * GetMaterial(std::string name);
 
         ProgramConfig * conf;
-        static RndEngine * rndEngine;
+        RndEngine * rndEngine = nullptr;
+
+        //Random numbers of the transport stream, drawn in bulk for each event
+        RandomBuffer eventRandom; //!
+        std::vector<RandomBuffer> batchRandom; //! One buffer for each event of the block
+        RandomBuffer * random = nullptr; //! Buffer of the event being transported
         bool msg = false;
 
         void ProcessTrack(Track * currentTrack);
-        void ProcessHit(Track * &currentTrack, Hit * hit, int detectorId);
+
+        //Transport specialized on the PhysicsPolicy bits kFlags, selected once by SelectTransport
+        typedef void (ExperimentSimulation::*EventTransport)(EventManager *);
+        typedef void (ExperimentSimulation::*BatchTransport)(std::vector<EventManager *> &);
+        typedef void (ExperimentSimulation::*HitRecorder)(EventManager *, ULong64_t, Double_t, Double_t, Double_t, int);
+        EventTransport eventTransport = nullptr; //!
+        BatchTransport batchTransport = nullptr; //!
+        HitRecorder recordHit = nullptr; //!
+
+        template<unsigned int kFlags> void SelectTransportFlags(unsigned int flags);
+        template<unsigned int kFlags> void TransportStates(EventManager * currentEvent);
+        template<unsigned int kFlags> void TransportBatch(std::vector<EventManager *> &events);
+
+        /// @brief Moves a particle of a non persistent event to the next layer, updating its state in place
+        template<unsigned int kFlags> void ProcessTrackState(EventManager * currentEvent, TrackState &state);
+
+        /// @brief Applies the multiple scattering of the given layer to a unit direction
+        /// @return False if the particle stops in this layer (outer layer or multiple scattering disabled)
+        template<unsigned int kFlags> bool ScatterAtLayer(int layer, Double_t p, Double_t beta, TransportReal &dx, TransportReal &dy, TransportReal &dz);
+        //The layer arguments and the return value of GetGeomIntersection are indices in layerTable
+        void ProcessHit(Track * &currentTrack, Hit * hit, int layer);
+        template<unsigned int kFlags> void RecordHit(EventManager * currentEvent, ULong64_t particleID, Double_t xHit, Double_t yHit, Double_t zHit, int layer);
         int  GetGeomIntersection(Track * currentTrack, Hit * hit);
 
-};
+        /// @brief False if the point of the layer is in a gap between its modules. The particle crosses the gaps without interacting.
+        bool InModule(int layer, Double_t x, Double_t y, Double_t z) {return ModuleGrid::FindModule(moduleGrid[layerTable.detectorID[layer]], x, y, z) >= 0;}
 
-//Definition of static data members
-RndEngine * ExperimentSimulation::rndEngine;
+        //Batched transport
+        TrackBatch batch;
+        void GatherTracks(std::vector<EventManager *> &events);
+        void BatchIntersection();
+
+};
 
 #endif
@@ -0,0 +1,296 @@
+#ifndef FASTMATH_H
+#define FASTMATH_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+/*
+    Elementary functions for the hot loops of the simulation and of the reconstruction.
+
+    Three precision tiers, selected at compile time with TANS_MATH_PRECISION (start.cxx options "exactmath"
+    and "fastmath") or per call with the template parameter:
+      kExact      the libm functions, reference implementation
+      kAccurate   (default) polynomial kernels with max error < 5e-16 (absolute for angles and sin/cos,
+                  relative for exp) in the documented domains
+      kFast       shorter polynomials, max error < 4e-7 (absolute for angles and sin/cos, relative for exp)
+
+    Apart from the libm fallback outside the documented domains the polynomial paths are branch free: the
+    quadrant and exponent manipulations are done in double arithmetic and the selections compile to blends.
+    The array entry points (SinCosArray, EtaToPolarArray) run the polynomial kernels in plain loops over the
+    whole array, which the compiler vectorizes (SSE2 by default, AVX2/AVX-512 with the "native" option), and
+    then apply the libm fallback to the few elements outside the domain. They give the same values as the
+    scalar functions.
+*/
+
+#include<cmath>
+#include<cstring>
+#include<cstdint>
+
+namespace FastMath
+{
+    enum Precision {kExact = 0, kAccurate = 1, kFast = 2};
+
+#ifdef TANS_MATH_PRECISION
+    const int kDefaultPrecision = TANS_MATH_PRECISION;
+#else
+    const int kDefaultPrecision = kAccurate;
+#endif
+
+    const double kPi      = 3.14159265358979323846;
+    const double kPiOver2 = 1.57079632679489661923;
+    const double kPiOver4 = 0.78539816339744830962;
+
+    const int kArrayBlock = 8; //Block length of the array entry points
+
+    //Rounding to the nearest integer of |x| < 2^51, without calls (exact in the default rounding mode)
+    inline double RoundNearest(double x)
+    {
+        const double magic = 6755399441055744.0; //1.5 * 2^52
+        return (x + magic) - magic;
+    }
+
+    //Polynomial sine and cosine of |x| < 1e5, without branches
+    template<int P>
+    inline void SinCosKernel(double x, double &s, double &c)
+    {
+        //Reduction to |r| <= pi/4 with pi/2 split in three parts (Cody-Waite), x = k pi/2 + r
+        double k = RoundNearest(x * 0.63661977236758134308);
+        double r = x - k * 1.57079632673412561417e+00;
+        r = r - k * 6.07710050630396597660e-11;
+        r = r - k * 2.02226624871116645580e-21;
+        double z = r * r;
+
+        double ps, pc;
+        if (P == kFast)
+        {
+            ps = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03 + z * -1.98412698298579493134e-04));
+            pc = 1. - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 + z * 2.48015872894767294178e-05));
+        }
+        else
+        {
+            //Minimax kernels of fdlibm on [-pi/4, pi/4]
+            ps = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04
+               + z * (2.75573137070700676789e-06 + z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+            pc = 1. - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 + z * (2.48015872894767294178e-05
+               + z * (-2.75573143513906633035e-07 + z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+        }
+
+        //Quadrant q = k mod 4, in double arithmetic: k/4 - 3/8 is never a tie, so its rounding is floor(k/4)
+        double q = k - 4. * RoundNearest(k * 0.25 - 0.375);
+        bool odd = std::fabs(q - 2.) == 1.;
+        double sq = odd ? pc : ps;
+        double cq = odd ? ps : pc;
+        s = (q >= 2.) ? -sq : sq;
+        c = (std::fabs(q - 1.5) < 1.) ? -cq : cq;
+    }
+
+    /// @brief Sine and cosine of the same angle. Domain of the polynomial tiers: |x| < 1e5.
+    template<int P = kDefaultPrecision>
+    inline void SinCos(double x, double &s, double &c)
+    {
+        if (P == kExact || !(std::fabs(x) < 1e5))
+        {
+            s = std::sin(x);
+            c = std::cos(x);
+            return;
+        }
+        SinCosKernel<P>(x, s, c);
+    }
+
+    /// @brief SinCos of the n angles of an array
+    template<int P = kDefaultPrecision>
+    inline void SinCosArray(unsigned int n, const double * x, double * s, double * c)
+    {
+        if (P == kExact)
+        {
+            for (unsigned int i = 0; i < n; ++i) SinCos<kExact>(x[i], s[i], c[i]);
+            return;
+        }
+
+        //Blocks of fixed length staged in local arrays, which cannot alias: the kernel loop is vectorized also
+        //by the cheap cost model of -O2. The remainder is done one element at a time.
+        unsigned int nBlocks = n - n % kArrayBlock;
+        for (unsigned int i = 0; i < nBlocks; i += kArrayBlock)
+        {
+            double bx[kArrayBlock], bs[kArrayBlock], bc[kArrayBlock];
+            for (int j = 0; j < kArrayBlock; ++j) bx[j] = x[i + j];
+            for (int j = 0; j < kArrayBlock; ++j) SinCosKernel<P>(bx[j], bs[j], bc[j]);
+            for (int j = 0; j < kArrayBlock; ++j)
+            {
+                s[i + j] = bs[j];
+                c[i + j] = bc[j];
+            }
+        }
+        for (unsigned int i = nBlocks; i < n; ++i) SinCosKernel<P>(x[i], s[i], c[i]);
+
+        for (unsigned int i = 0; i < n; ++i)
+            if (!(std::fabs(x[i]) < 1e5)) SinCos<kExact>(x[i], s[i], c[i]);
+    }
+
+    /// @brief Sine and cosine of a small angle (e.g. a multiple scattering angle) with the Taylor series, without argument reduction. The error of the series is below 1e-17 for |x| < 0.05, larger angles use SinCos.
+    template<int P = kDefaultPrecision>
+    inline void SinCosSmall(double x, double &s, double &c)
+    {
+        if (P == kExact || !(std::fabs(x) < 0.05))
+        {
+            SinCos<P>(x, s, c);
+            return;
+        }
+
+        double z = x * x;
+        s = x + x * z * (-1./6 + z * (1./120 + z * (-1./5040)));
+        c = 1. + z * (-1./2 + z * (1./24 + z * (-1./720 + z * (1./40320))));
+    }
+
+    //Arctangent of 0 <= x <= 1
+    template<int P>
+    inline double AtanUnit(double x)
+    {
+        if (P == kFast)
+        {
+            //Float kernel of Cephes on |x| <= tan(pi/8)
+            bool reduce = x > 0.41421356237309504880;
+            double t = reduce ? (x - 1.) / (x + 1.) : x;
+            double z = t * t;
+            double a = (((8.05374449538e-2 * z - 1.38776856032e-1) * z + 1.99777106478e-1) * z - 3.33329491539e-1) * z * t + t;
+            return reduce ? kPiOver4 + a : a;
+        }
+
+        //Rational kernel of Cephes, reduction at 0.66
+        bool reduce = x > 0.66;
+        double t = reduce ? (x - 1.) / (x + 1.) : x;
+        double z = t * t;
+        double p = (((-8.750608600031904122785e-1 * z - 1.615753718733365076637e1) * z - 7.500855792314704667340e1) * z - 1.228866684490136173410e2) * z - 6.485021904942025371773e1;
+        double q = ((((z + 2.485846490142306297962e1) * z + 1.650270098316988542046e2) * z + 4.328810604912902668951e2) * z + 4.853903996359136964868e2) * z + 1.945506571482613964425e2;
+        double a = t + t * z * p / q;
+        return reduce ? kPiOver4 + (a + 0.5 * 6.123233995736765886130e-17) : a;
+    }
+
+    /// @brief Arctangent, in [-pi/2, pi/2]
+    template<int P = kDefaultPrecision>
+    inline double Atan(double x)
+    {
+        if (P == kExact) return std::atan(x);
+
+        double ax = std::fabs(x);
+        bool invert = ax > 1.;
+        double a = AtanUnit<P>(invert ? 1. / ax : ax);
+        a = invert ? kPiOver2 - a : a;
+        return (x < 0) ? -a : a;
+    }
+
+    /// @brief Angle of the point (x, y), in [-pi, pi] as std::atan2
+    template<int P = kDefaultPrecision>
+    inline double Atan2(double y, double x)
+    {
+        if (P == kExact) return std::atan2(y, x);
+
+        double ax = std::fabs(x);
+        double ay = std::fabs(y);
+        bool swap = ay > ax;
+        double num = swap ? ax : ay;
+        double den = swap ? ay : ax;
+        double a = AtanUnit<P>((den > 0) ? num / den : 0.);
+        a = swap ? kPiOver2 - a : a;
+        a = std::signbit(x) ? kPi - a : a;
+        return std::signbit(y) ? -a : a;
+    }
+
+    //Polynomial exponential of |x| < 708, without branches
+    template<int P>
+    inline double ExpKernel(double x)
+    {
+        //x = k ln2 + r, |r| <= ln2/2
+        double k = RoundNearest(x * 1.44269504088896338700);
+        double r = x - k * 6.93147180369123816490e-01;
+        r = r - k * 1.90821492927058770002e-10;
+
+        //Taylor series of exp(r)
+        double p;
+        if (P == kFast)
+            p = 1. + r * (1. + r * (1./2 + r * (1./6 + r * (1./24 + r * (1./120 + r * (1./720 + r * (1./5040 + r * (1./40320))))))));
+        else
+            p = 1. + r * (1. + r * (1./2 + r * (1./6 + r * (1./24 + r * (1./120 + r * (1./720 + r * (1./5040 + r * (1./40320
+              + r * (1./362880 + r * (1./3628800 + r * (1./39916800 + r * (1./479001600 + r * (1./6227020800.)))))))))))));
+
+        //Multiplication by 2^k through the exponent bits: the biased exponent k + 1023 (1 ... 2046) is read from
+        //the low mantissa bits of k + 1023 + 1.5 * 2^52 and shifted in place, the upper bits are shifted out
+        double biased = (k + 1023.) + 6755399441055744.0;
+        uint64_t bits;
+        std::memcpy(&bits, &biased, sizeof(bits));
+        bits = bits << 52;
+        double scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    /// @brief Exponential. Domain of the polynomial tiers: |x| < 708.
+    template<int P = kDefaultPrecision>
+    inline double Exp(double x)
+    {
+        if (P == kExact || !(std::fabs(x) < 708.)) return std::exp(x);
+        return ExpKernel<P>(x);
+    }
+
+    //Polar angle from exp(-|eta|), see EtaToPolar
+    inline void EtaToPolarKernel(double eta, double u, double &sinTheta, double &cosTheta)
+    {
+        //exp(-2|eta|) is in (0, 1], the identities are evaluated without cancellations
+        double e2 = u * u;
+        double inv = 1. / (1. + e2);
+        sinTheta = 2. * u * inv;
+        double th = (1. - e2) * inv;
+        cosTheta = (eta < 0) ? -th : th;
+    }
+
+    /// @brief Polar angle of the direction with pseudorapidity eta, theta = 2 atan(exp(-eta)), given as sin(theta) = 1 / cosh(eta) and cos(theta) = tanh(eta) with a single exponential
+    template<int P = kDefaultPrecision>
+    inline void EtaToPolar(double eta, double &sinTheta, double &cosTheta)
+    {
+        if (P == kExact)
+        {
+            double theta = 2 * std::atan(std::exp(-eta));
+            sinTheta = std::sin(theta);
+            cosTheta = std::cos(theta);
+            return;
+        }
+
+        EtaToPolarKernel(eta, Exp<P>(-std::fabs(eta)), sinTheta, cosTheta);
+    }
+
+    /// @brief EtaToPolar of the n pseudorapidities of an array
+    template<int P = kDefaultPrecision>
+    inline void EtaToPolarArray(unsigned int n, const double * eta, double * sinTheta, double * cosTheta)
+    {
+        if (P == kExact)
+        {
+            for (unsigned int i = 0; i < n; ++i) EtaToPolar<kExact>(eta[i], sinTheta[i], cosTheta[i]);
+            return;
+        }
+
+        //Same staging as SinCosArray
+        unsigned int nBlocks = n - n % kArrayBlock;
+        for (unsigned int i = 0; i < nBlocks; i += kArrayBlock)
+        {
+            double be[kArrayBlock], bs[kArrayBlock], bc[kArrayBlock];
+            for (int j = 0; j < kArrayBlock; ++j) be[j] = eta[i + j];
+            for (int j = 0; j < kArrayBlock; ++j) EtaToPolarKernel(be[j], ExpKernel<P>(-std::fabs(be[j])), bs[j], bc[j]);
+            for (int j = 0; j < kArrayBlock; ++j)
+            {
+                sinTheta[i + j] = bs[j];
+                cosTheta[i + j] = bc[j];
+            }
+        }
+        for (unsigned int i = nBlocks; i < n; ++i)
+            EtaToPolarKernel(eta[i], ExpKernel<P>(-std::fabs(eta[i])), sinTheta[i], cosTheta[i]);
+
+        for (unsigned int i = 0; i < n; ++i)
+            if (!(std::fabs(eta[i]) < 708.)) EtaToPolar<P>(eta[i], sinTheta[i], cosTheta[i]);
+    }
+}
+
+#endif
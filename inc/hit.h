@@ -8,6 +8,8 @@
 *   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
 */
 
+#include<atomic>
+
 #include<TObject.h>
 #include<TVector3.h>
 
@@ -16,7 +18,8 @@ class Hit: public TVector3
 {
     public:
         Hit() {SetHitId();}
-        Hit(const Hit &hitSource) : TVector3(){
+        Hit(const Hit &hitSource) : TVector3(hitSource){
+            t = hitSource.t;
             isOnSensitiveDetector = hitSource.isOnSensitiveDetector;
             sensitiveDetectorId = hitSource.sensitiveDetectorId;
             edep = hitSource.edep;
@@ -35,7 +38,7 @@ class Hit: public TVector3
 
     private:
         Double_t t;
-        static ULong64_t hitIdGenerator; //!
+        static std::atomic<ULong64_t> hitIdGenerator; //!
         ULong64_t hitID;
         void SetHitId() {hitID = ++hitIdGenerator;}
 
@@ -43,7 +46,7 @@ class Hit: public TVector3
 };
 
 //Definition of static class members
-ULong64_t Hit::hitIdGenerator;
+std::atomic<ULong64_t> Hit::hitIdGenerator(0);
 
 //Directives for dictionary generation by ROOTCLING for ACliC
 #if defined(__ROOTCLING__)
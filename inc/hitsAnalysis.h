@@ -20,6 +20,7 @@
 #include "TNamed.h"
 #include "../inc/runManager.h"
 #include "../inc/conf.h"
+#include "../inc/fastMath.h"
 
 class HitsAnalysis : public TNamed
 {
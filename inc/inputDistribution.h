@@ -0,0 +1,152 @@
+#ifndef INPUTDISTRIBUTION_H
+#define INPUTDISTRIBUTION_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+/*
+    Input distributions of the simulation. A distribution is either a histogram of the input file, sampled with
+    its alias table, or one of the parametric shapes of the configuration GUI, written in the configuration file
+    in place of the name of the histogram and sampled directly, without binning:
+      uniform(a,b)      gaus(mu,sigma)      poisson(mean)       fixed(x)
+    The 2D shapes have independent coordinates:
+      uniform(xMin,xMax,yMin,yMax)      gaus(muX,sigmaX,muY,sigmaY)     fixed(x,y)
+*/
+
+#include<cstdlib>
+#include<string>
+#include<sstream>
+#include<vector>
+
+#include "../inc/aliasSampler.h"
+
+namespace InputDistribution
+{
+    enum Shape {kHistogram = 0, kUniform = 1, kGaussian = 2, kPoisson = 3, kFixed = 4};
+}
+
+/// @brief 1D input distribution, histogram or parametric
+typedef struct {
+    int shape = InputDistribution::kHistogram;
+    Double_t par[2] = {0., 0.};
+    HistogramSampler histogram;
+    } Distribution1D;
+
+/// @brief 2D input distribution, histogram or parametric
+typedef struct {
+    int shape = InputDistribution::kHistogram;
+    Double_t par[4] = {0., 0., 0., 0.};
+    Histogram2DSampler histogram;
+    } Distribution2D;
+
+namespace InputDistribution
+{
+    /// @brief Reads a parametric definition "name(p0,p1,...)" of a distribution with the given number of dimensions
+    /// @param shape Set to the shape of the definition
+    /// @param par Set to the parameters of the definition in the order of the configuration file, 2 * dimensions values
+    /// @return False if the value is not a valid parametric definition
+    inline bool Parse(const std::string &value, unsigned int dimensions, int &shape, Double_t * par)
+    {
+        size_t open = value.find('(');
+        size_t close = value.rfind(')');
+        if (open == std::string::npos || close == std::string::npos || close < open) return false;
+
+        std::string name = value.substr(0, open);
+        std::vector<Double_t> values;
+        std::stringstream valuestream(value.substr(open + 1, close - open - 1));
+        std::string field;
+        while(std::getline(valuestream, field, ','))
+            values.push_back(atof(field.c_str()));
+
+        //Number of parameters of each shape in 1D and 2D
+        unsigned int nPar = 0;
+        if (name == "uniform")      {shape = kUniform; nPar = 2 * dimensions;}
+        else if (name == "gaus")    {shape = kGaussian; nPar = 2 * dimensions;}
+        else if (name == "poisson") {shape = kPoisson; nPar = (dimensions == 1) ? 1 : 0;}
+        else if (name == "fixed")   {shape = kFixed; nPar = dimensions;}
+
+        if (nPar == 0 || values.size() != nPar) return false;
+        for (unsigned int i = 0; i < 2 * dimensions; ++i)
+            par[i] = (i < nPar) ? values[i] : 0.;
+        return true;
+    }
+
+    /// @brief Random value of a 1D distribution
+    /// @param rnd Random engine (TRandom) or RandomBuffer (not for the Poisson shape)
+    template<typename Random>
+    inline Double_t Sample(const Distribution1D &d, Random * rnd)
+    {
+        switch (d.shape)
+        {
+            case kUniform:  return d.par[0] + (d.par[1] - d.par[0]) * rnd->Rndm();
+            case kGaussian: return rnd->Gaus(d.par[0], d.par[1]);
+            case kPoisson:  return (Double_t)rnd->Poisson(d.par[0]);
+            case kFixed:    return d.par[0];
+            default:        return AliasSampler::Sample(d.histogram, rnd);
+        }
+    }
+
+    /// @brief Random count (multiplicity, collisions per event) of a 1D distribution, never negative. The histograms keep the truncation of the bin value (bin [n, n+1) gives n), the continuous parametric shapes are rounded to the nearest integer.
+    template<typename Random>
+    inline unsigned int SampleCount(const Distribution1D &d, Random * rnd)
+    {
+        Double_t value = Sample(d, rnd);
+        if (d.shape != kHistogram) value += 0.5;
+        return (value > 0) ? (unsigned int)value : 0;
+    }
+
+    /// @brief Fills an array with random values of a 1D distribution, drawing the uniform and normal numbers in bulk
+    /// @param rnd Random engine with RndmArray and GausArray (RndEngine)
+    template<typename Random>
+    inline void SampleArray(const Distribution1D &d, unsigned int n, Double_t * out, Random * rnd)
+    {
+        switch (d.shape)
+        {
+            case kUniform:
+                rnd->RndmArray(n, out);
+                for (unsigned int i = 0; i < n; ++i) out[i] = d.par[0] + (d.par[1] - d.par[0]) * out[i];
+                return;
+            case kGaussian:
+                rnd->GausArray(n, out);
+                for (unsigned int i = 0; i < n; ++i) out[i] = d.par[0] + d.par[1] * out[i];
+                return;
+            case kPoisson:
+                for (unsigned int i = 0; i < n; ++i) out[i] = (Double_t)rnd->Poisson(d.par[0]);
+                return;
+            case kFixed:
+                for (unsigned int i = 0; i < n; ++i) out[i] = d.par[0];
+                return;
+            default:
+                AliasSampler::SampleArray(d.histogram, n, out, rnd);
+        }
+    }
+
+    /// @brief Random point of a 2D distribution
+    template<typename Random>
+    inline void Sample2D(const Distribution2D &d, Double_t &x, Double_t &y, Random * rnd)
+    {
+        switch (d.shape)
+        {
+            case kUniform:
+                x = d.par[0] + (d.par[1] - d.par[0]) * rnd->Rndm();
+                y = d.par[2] + (d.par[3] - d.par[2]) * rnd->Rndm();
+                return;
+            case kGaussian:
+                x = rnd->Gaus(d.par[0], d.par[1]);
+                y = rnd->Gaus(d.par[2], d.par[3]);
+                return;
+            case kFixed:
+                x = d.par[0];
+                y = d.par[1];
+                return;
+            default:
+                AliasSampler::Sample2D(d.histogram, x, y, rnd);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,418 @@
+#ifndef INTERSECTIONKERNEL_H
+#define INTERSECTIONKERNEL_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+/*
+    Intersection between straight tracks and the cylindrical layers of the detector.
+
+    The SIMD path is used when the compiler targets AVX-512, AVX2 or SSE2 (start.cxx option "native" compiles
+    with -march=native). Compiling with -DTANS_SCALAR_INTERSECTION (start.cxx option "scalar") selects the scalar path.
+
+    Both paths evaluate the same IEEE operations in the same order (mul, add, sub, sqrt and div are correctly
+    rounded also in the vector units), so the results are identical unless the compiler contracts a*b+c into
+    a fused multiply-add (-ffp-contract, default on GCC with FMA targets): in that case the intersection times
+    of the two paths differ by a few ulp (relative difference < 1e-11) and the selected layer is the same except
+    for hits closer than that to a layer edge.
+
+    IntersectTracks is a template on the floating point type of the tracks: in single precision (TransportReal,
+    -DTANS_SINGLE_PRECISION) each SIMD register holds twice as many tracks. The scalar fallbacks and the layer
+    table are always in double precision.
+*/
+
+#include<vector>
+#include<TMath.h>
+
+#if !defined(TANS_SCALAR_INTERSECTION) && (defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__))
+#define TANS_SIMD_INTERSECTION
+#include<immintrin.h>
+#endif
+
+/// @brief Flat table of the detector layers sorted by increasing radius, compiled from the geometry register. R2 and H are padded with invalid layers (H < 0) to a multiple of the widest SIMD register.
+typedef struct {
+    std::vector<Double_t> R;            //Mean radius
+    std::vector<Double_t> R2;           //Squared mean radius
+    std::vector<Double_t> H;            //Half length
+    std::vector<Double_t> thickness;    //Thickness of the layer
+    std::vector<Double_t> radLength;    //Radiation length of the material
+    std::vector<Double_t> zMat;         //Atomic number of the material
+    std::vector<int> detectorID;        //Index of the layer in the geometry register
+    std::vector<bool> sensitive;        //Hits are recorded only on the sensitive layers
+    unsigned int nLayers = 0;           //Number of real layers, without the padding
+    } LayerTable;
+
+namespace IntersectionKernel
+{
+    const unsigned int kPadding = 8;
+    const Double_t kMinTime = 1e-15;
+    const Double_t kMaxTime = 1.; //1s
+
+    /// @brief Inserts a layer in the table, keeping the radial order and the padding
+    inline void AddLayer(LayerTable &table, Double_t R, Double_t H, Double_t thickness, Double_t radLength, Double_t zMat, int detectorID, bool sensitive)
+    {
+        unsigned int pos = 0;
+        while (pos < table.nLayers && table.R[pos] <= R) pos++;
+
+        table.R2.resize(table.nLayers);
+        table.H.resize(table.nLayers);
+
+        table.R.insert(table.R.begin() + pos, R);
+        table.R2.insert(table.R2.begin() + pos, R * R);
+        table.H.insert(table.H.begin() + pos, H);
+        table.thickness.insert(table.thickness.begin() + pos, thickness);
+        table.radLength.insert(table.radLength.begin() + pos, radLength);
+        table.zMat.insert(table.zMat.begin() + pos, zMat);
+        table.detectorID.insert(table.detectorID.begin() + pos, detectorID);
+        table.sensitive.insert(table.sensitive.begin() + pos, sensitive);
+        table.nLayers++;
+
+        while (table.R2.size() % kPadding != 0)
+        {
+            table.R2.push_back(0.);
+            table.H.push_back(-1.);
+        }
+    }
+
+    /// @brief Index of the first layer with radius larger than the distance of (x, y) from the beam axis
+    inline unsigned int FirstLayerOutside(const LayerTable &table, Double_t x, Double_t y)
+    {
+        Double_t r2 = x*x + y*y;
+        unsigned int low = 0, high = table.nLayers;
+        while (low < high)
+        {
+            unsigned int mid = (low + high) / 2;
+            if (table.R2[mid] <= r2) low = mid + 1;
+            else high = mid;
+        }
+        return low;
+    }
+
+    /// @brief Scalar intersection of one track with all the layers
+    /// @param tMin Time of the first intersection, kMaxTime if there is none
+    /// @return Index of the intersected layer in the table, -1 if none
+    inline int IntersectScalar(Double_t x0, Double_t y0, Double_t z0, Double_t v1, Double_t v2, Double_t v3, const LayerTable &table, Double_t &tMin)
+    {
+        int index = -1;
+        tMin = kMaxTime;
+
+        Double_t b = x0*v1 + y0*v2;
+        Double_t a = v1*v1 + v2*v2;
+        Double_t r2 = x0*x0 + y0*y0;
+
+        for (unsigned int j = 0; j < table.nLayers; ++j)
+        {
+            Double_t Delta = b * b - a * (r2 - table.R2[j]);
+            Double_t t  = (-1. * b + TMath::Sqrt(Delta)) / a;
+            Double_t zz = z0 + v3*t;
+
+            if ((zz < table.H[j]) && (zz > (-1. * table.H[j])) && (t > kMinTime) && (t < tMin))
+            {
+                index = j;
+                tMin = t;
+            }
+        }
+
+        return index;
+    }
+
+#ifdef TANS_SIMD_INTERSECTION
+
+    //Thin wrappers around the intrinsics of the widest available instruction set
+#if defined(__AVX512F__)
+    const unsigned int kWidth = 8;
+    typedef __m512d vdouble;
+    typedef __mmask8 vmask;
+    inline vdouble Load(const Double_t * p)             {return _mm512_loadu_pd(p);}
+    inline void    Store(Double_t * p, vdouble a)       {_mm512_storeu_pd(p, a);}
+    inline vdouble Set1(Double_t a)                     {return _mm512_set1_pd(a);}
+    inline vdouble Add(vdouble a, vdouble b)            {return _mm512_add_pd(a, b);}
+    inline vdouble Sub(vdouble a, vdouble b)            {return _mm512_sub_pd(a, b);}
+    inline vdouble Mul(vdouble a, vdouble b)            {return _mm512_mul_pd(a, b);}
+    inline vdouble Div(vdouble a, vdouble b)            {return _mm512_div_pd(a, b);}
+    inline vdouble Sqrt(vdouble a)                      {return _mm512_sqrt_pd(a);}
+    inline vmask   Less(vdouble a, vdouble b)           {return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);}
+    inline vmask   And(vmask a, vmask b)                {return a & b;}
+    inline vdouble Select(vmask m, vdouble a, vdouble b){return _mm512_mask_blend_pd(m, b, a);}
+
+    const unsigned int kWidthFloat = 16;
+    typedef __m512 vfloat;
+    typedef __mmask16 vmaskf;
+    inline vfloat  Load(const Float_t * p)              {return _mm512_loadu_ps(p);}
+    inline void    Store(Float_t * p, vfloat a)         {_mm512_storeu_ps(p, a);}
+    inline vfloat  Set1(Float_t a)                      {return _mm512_set1_ps(a);}
+    inline vfloat  Add(vfloat a, vfloat b)              {return _mm512_add_ps(a, b);}
+    inline vfloat  Sub(vfloat a, vfloat b)              {return _mm512_sub_ps(a, b);}
+    inline vfloat  Mul(vfloat a, vfloat b)              {return _mm512_mul_ps(a, b);}
+    inline vfloat  Div(vfloat a, vfloat b)              {return _mm512_div_ps(a, b);}
+    inline vfloat  Sqrt(vfloat a)                       {return _mm512_sqrt_ps(a);}
+    inline vmaskf  Less(vfloat a, vfloat b)             {return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);}
+    inline vmaskf  And(vmaskf a, vmaskf b)              {return a & b;}
+    inline vfloat  Select(vmaskf m, vfloat a, vfloat b) {return _mm512_mask_blend_ps(m, b, a);}
+#elif defined(__AVX2__)
+    const unsigned int kWidth = 4;
+    typedef __m256d vdouble;
+    typedef __m256d vmask;
+    inline vdouble Load(const Double_t * p)             {return _mm256_loadu_pd(p);}
+    inline void    Store(Double_t * p, vdouble a)       {_mm256_storeu_pd(p, a);}
+    inline vdouble Set1(Double_t a)                     {return _mm256_set1_pd(a);}
+    inline vdouble Add(vdouble a, vdouble b)            {return _mm256_add_pd(a, b);}
+    inline vdouble Sub(vdouble a, vdouble b)            {return _mm256_sub_pd(a, b);}
+    inline vdouble Mul(vdouble a, vdouble b)            {return _mm256_mul_pd(a, b);}
+    inline vdouble Div(vdouble a, vdouble b)            {return _mm256_div_pd(a, b);}
+    inline vdouble Sqrt(vdouble a)                      {return _mm256_sqrt_pd(a);}
+    inline vmask   Less(vdouble a, vdouble b)           {return _mm256_cmp_pd(a, b, _CMP_LT_OQ);}
+    inline vmask   And(vmask a, vmask b)                {return _mm256_and_pd(a, b);}
+    inline vdouble Select(vmask m, vdouble a, vdouble b){return _mm256_blendv_pd(b, a, m);}
+
+    const unsigned int kWidthFloat = 8;
+    typedef __m256 vfloat;
+    typedef __m256 vmaskf;
+    inline vfloat  Load(const Float_t * p)              {return _mm256_loadu_ps(p);}
+    inline void    Store(Float_t * p, vfloat a)         {_mm256_storeu_ps(p, a);}
+    inline vfloat  Set1(Float_t a)                      {return _mm256_set1_ps(a);}
+    inline vfloat  Add(vfloat a, vfloat b)              {return _mm256_add_ps(a, b);}
+    inline vfloat  Sub(vfloat a, vfloat b)              {return _mm256_sub_ps(a, b);}
+    inline vfloat  Mul(vfloat a, vfloat b)              {return _mm256_mul_ps(a, b);}
+    inline vfloat  Div(vfloat a, vfloat b)              {return _mm256_div_ps(a, b);}
+    inline vfloat  Sqrt(vfloat a)                       {return _mm256_sqrt_ps(a);}
+    inline vmaskf  Less(vfloat a, vfloat b)             {return _mm256_cmp_ps(a, b, _CMP_LT_OQ);}
+    inline vmaskf  And(vmaskf a, vmaskf b)              {return _mm256_and_ps(a, b);}
+    inline vfloat  Select(vmaskf m, vfloat a, vfloat b) {return _mm256_blendv_ps(b, a, m);}
+#else
+    const unsigned int kWidth = 2;
+    typedef __m128d vdouble;
+    typedef __m128d vmask;
+    inline vdouble Load(const Double_t * p)             {return _mm_loadu_pd(p);}
+    inline void    Store(Double_t * p, vdouble a)       {_mm_storeu_pd(p, a);}
+    inline vdouble Set1(Double_t a)                     {return _mm_set1_pd(a);}
+    inline vdouble Add(vdouble a, vdouble b)            {return _mm_add_pd(a, b);}
+    inline vdouble Sub(vdouble a, vdouble b)            {return _mm_sub_pd(a, b);}
+    inline vdouble Mul(vdouble a, vdouble b)            {return _mm_mul_pd(a, b);}
+    inline vdouble Div(vdouble a, vdouble b)            {return _mm_div_pd(a, b);}
+    inline vdouble Sqrt(vdouble a)                      {return _mm_sqrt_pd(a);}
+    inline vmask   Less(vdouble a, vdouble b)           {return _mm_cmplt_pd(a, b);}
+    inline vmask   And(vmask a, vmask b)                {return _mm_and_pd(a, b);}
+    inline vdouble Select(vmask m, vdouble a, vdouble b){return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));}
+
+    const unsigned int kWidthFloat = 4;
+    typedef __m128 vfloat;
+    typedef __m128 vmaskf;
+    inline vfloat  Load(const Float_t * p)              {return _mm_loadu_ps(p);}
+    inline void    Store(Float_t * p, vfloat a)         {_mm_storeu_ps(p, a);}
+    inline vfloat  Set1(Float_t a)                      {return _mm_set1_ps(a);}
+    inline vfloat  Add(vfloat a, vfloat b)              {return _mm_add_ps(a, b);}
+    inline vfloat  Sub(vfloat a, vfloat b)              {return _mm_sub_ps(a, b);}
+    inline vfloat  Mul(vfloat a, vfloat b)              {return _mm_mul_ps(a, b);}
+    inline vfloat  Div(vfloat a, vfloat b)              {return _mm_div_ps(a, b);}
+    inline vfloat  Sqrt(vfloat a)                       {return _mm_sqrt_ps(a);}
+    inline vmaskf  Less(vfloat a, vfloat b)             {return _mm_cmplt_ps(a, b);}
+    inline vmaskf  And(vmaskf a, vmaskf b)              {return _mm_and_ps(a, b);}
+    inline vfloat  Select(vmaskf m, vfloat a, vfloat b) {return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));}
+#endif
+
+    //Vector types of the batched kernel for double and single precision tracks
+    template<typename Real> struct SimdType;
+    template<> struct SimdType<Double_t> {typedef vdouble Vec; typedef vmask Mask; static const unsigned int kWidth = IntersectionKernel::kWidth;};
+    template<> struct SimdType<Float_t>  {typedef vfloat Vec;  typedef vmaskf Mask; static const unsigned int kWidth = kWidthFloat;};
+
+    /// @brief Intersection of one track with kWidth layers at a time, followed by the masked min-reduction over the layers
+    inline int IntersectLayers(Double_t x0, Double_t y0, Double_t z0, Double_t v1, Double_t v2, Double_t v3, const LayerTable &table, Double_t &tMin)
+    {
+        int index = -1;
+        tMin = kMaxTime;
+
+        vdouble b  = Set1(x0*v1 + y0*v2);
+        vdouble a  = Set1(v1*v1 + v2*v2);
+        vdouble r2 = Set1(x0*x0 + y0*y0);
+        vdouble vz = Set1(v3);
+        vdouble zs = Set1(z0);
+        vdouble minusOne = Set1(-1.);
+        vdouble minTime  = Set1(kMinTime);
+        vdouble maxTime  = Set1(kMaxTime);
+
+        Double_t t[kWidth];
+        for (unsigned int j = 0; j < table.nLayers; j += kWidth)
+        {
+            vdouble H = Load(&table.H[j]);
+            vdouble Delta = Sub(Mul(b, b), Mul(a, Sub(r2, Load(&table.R2[j]))));
+            vdouble tt = Div(Add(Mul(minusOne, b), Sqrt(Delta)), a);
+            vdouble zz = Add(zs, Mul(vz, tt));
+
+            vmask valid = And(And(Less(zz, H), Less(Mul(minusOne, H), zz)), Less(minTime, tt));
+            Store(t, Select(valid, tt, maxTime));
+
+            for (unsigned int k = 0; k < kWidth; ++k)
+            {
+                if (t[k] < tMin)
+                {
+                    index = j + k;
+                    tMin = t[k];
+                }
+            }
+        }
+
+        return index;
+    }
+
+#else
+
+    /// @brief Scalar path, same interface of the SIMD kernel
+    inline int IntersectLayers(Double_t x0, Double_t y0, Double_t z0, Double_t v1, Double_t v2, Double_t v3, const LayerTable &table, Double_t &tMin)
+    {
+        return IntersectScalar(x0, y0, z0, v1, v2, v3, table, tMin);
+    }
+
+#endif
+
+    /// @brief Intersection of one track with the layers outside the given one. A track moving outward crosses the layers in radial order, so the first layer with a valid intersection is the earliest one and usually it is the first tested. Tracks moving inward fall back to the scan of all the layers.
+    /// @param first Index in the table of the first layer that can be crossed (the one after the last crossed layer)
+    /// @param tMin Time of the intersection, kMaxTime if there is none
+    /// @return Index of the intersected layer in the table, -1 if none
+    inline int IntersectNext(Double_t x0, Double_t y0, Double_t z0, Double_t v1, Double_t v2, Double_t v3, const LayerTable &table, unsigned int first, Double_t &tMin)
+    {
+        Double_t b = x0*v1 + y0*v2;
+        if (b < 0) return IntersectLayers(x0, y0, z0, v1, v2, v3, table, tMin);
+
+        Double_t a = v1*v1 + v2*v2;
+        Double_t r2 = x0*x0 + y0*y0;
+
+        for (unsigned int j = first; j < table.nLayers; ++j)
+        {
+            Double_t Delta = b * b - a * (r2 - table.R2[j]);
+            Double_t t  = (-1. * b + TMath::Sqrt(Delta)) / a;
+            Double_t zz = z0 + v3*t;
+
+            if ((zz < table.H[j]) && (zz > (-1. * table.H[j])) && (t > kMinTime) && (t < kMaxTime))
+            {
+                tMin = t;
+                return j;
+            }
+        }
+
+        tMin = kMaxTime;
+        return -1;
+    }
+
+#ifdef TANS_SIMD_INTERSECTION
+
+    /// @brief Next layer stepping of several tracks at a time (kWidth in double precision, kWidthFloat in single precision). Each track is described by its start point, unit direction and speed, as in TrackBatch. Every lane tests its own next layer; the lanes without a valid intersection move to the following layer until all of them are resolved.
+    /// @param first Index in the table of the first layer that can be crossed by each track
+    /// @param tHit Output, time of the intersection of each track (kMaxTime if none)
+    /// @param layer Output, index in the table of the intersected layer (-1 if none)
+    template<typename Real>
+    inline void IntersectTracks(unsigned long int n, const Real * x0, const Real * y0, const Real * z0, const Real * dx, const Real * dy, const Real * dz, const Real * speed, const int * first, const LayerTable &table, Real * tHit, int * layer)
+    {
+        typedef typename SimdType<Real>::Vec Vec;
+        typedef typename SimdType<Real>::Mask Mask;
+        const unsigned int width = SimdType<Real>::kWidth;
+
+        Vec minusOne = Set1((Real)-1.);
+        Vec minTime  = Set1((Real)kMinTime);
+        Vec maxTime  = Set1((Real)kMaxTime);
+        Vec one  = Set1((Real)1.);
+        Vec zero = Set1((Real)0.);
+
+        Real R2[width], H[width], t[width], valid[width], bb[width];
+        int next[width];
+        int nLayers = table.nLayers;
+        Double_t tScalar;
+
+        unsigned long int i = 0;
+        for (; i + width <= n; i += width)
+        {
+            Vec s  = Load(speed + i);
+            Vec v1 = Mul(Load(dx + i), s);
+            Vec v2 = Mul(Load(dy + i), s);
+            Vec v3 = Mul(Load(dz + i), s);
+            Vec xs = Load(x0 + i);
+            Vec ys = Load(y0 + i);
+            Vec zs = Load(z0 + i);
+
+            Vec b  = Add(Mul(xs, v1), Mul(ys, v2));
+            Vec a  = Add(Mul(v1, v1), Mul(v2, v2));
+            Vec r2 = Add(Mul(xs, xs), Mul(ys, ys));
+            Store(bb, b);
+
+            bool pending = false;
+            for (unsigned int k = 0; k < width; ++k)
+            {
+                layer[i + k] = -1;
+                tHit[i + k] = kMaxTime;
+                next[k] = (bb[k] < 0) ? nLayers : first[i + k]; //Tracks moving inward are done by the scalar scan below
+                if (next[k] < nLayers) pending = true;
+            }
+
+            while (pending)
+            {
+                //Constants of the next layer of each lane, the lanes already resolved test an invalid layer
+                for (unsigned int k = 0; k < width; ++k)
+                {
+                    bool active = (layer[i + k] < 0) && (next[k] < nLayers);
+                    R2[k] = active ? table.R2[next[k]] : 0.;
+                    H[k]  = active ? table.H[next[k]] : -1.;
+                }
+
+                Vec Hv = Load(H);
+                Vec Delta = Sub(Mul(b, b), Mul(a, Sub(r2, Load(R2))));
+                Vec tt = Div(Add(Mul(minusOne, b), Sqrt(Delta)), a);
+                Vec zz = Add(zs, Mul(v3, tt));
+
+                Mask ok = And(And(And(Less(zz, Hv), Less(Mul(minusOne, Hv), zz)), Less(minTime, tt)), Less(tt, maxTime));
+                Store(t, tt);
+                Store(valid, Select(ok, one, zero));
+
+                pending = false;
+                for (unsigned int k = 0; k < width; ++k)
+                {
+                    if (layer[i + k] >= 0 || next[k] >= nLayers) continue;
+                    if (valid[k] != 0.)
+                    {
+                        layer[i + k] = next[k];
+                        tHit[i + k] = t[k];
+                    }
+                    else if (++next[k] < nLayers) pending = true;
+                }
+            }
+
+            for (unsigned int k = 0; k < width; ++k)
+            {
+                unsigned long int l = i + k;
+                if (bb[k] < 0)
+                {
+                    layer[l] = IntersectLayers(x0[l], y0[l], z0[l], dx[l] * speed[l], dy[l] * speed[l], dz[l] * speed[l], table, tScalar);
+                    tHit[l] = tScalar;
+                }
+            }
+        }
+
+        //Remaining tracks
+        for (; i < n; ++i)
+        {
+            layer[i] = IntersectNext(x0[i], y0[i], z0[i], dx[i] * speed[i], dy[i] * speed[i], dz[i] * speed[i], table, first[i], tScalar);
+            tHit[i] = tScalar;
+        }
+    }
+
+#else
+
+    /// @brief Scalar path, same interface of the SIMD kernel
+    template<typename Real>
+    inline void IntersectTracks(unsigned long int n, const Real * x0, const Real * y0, const Real * z0, const Real * dx, const Real * dy, const Real * dz, const Real * speed, const int * first, const LayerTable &table, Real * tHit, int * layer)
+    {
+        Double_t tScalar;
+        for (unsigned long int i = 0; i < n; ++i)
+        {
+            layer[i] = IntersectNext(x0[i], y0[i], z0[i], dx[i] * speed[i], dy[i] * speed[i], dz[i] * speed[i], table, first[i], tScalar);
+            tHit[i] = tScalar;
+        }
+    }
+
+#endif
+}
+
+#endif
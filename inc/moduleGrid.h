@@ -0,0 +1,94 @@
+#ifndef MODULEGRID_H
+#define MODULEGRID_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+/*
+    Segmentation of a cylindrical layer in pixel modules.
+
+    The modules are tiled on a regular (phi, z) grid: nPhi modules of width moduleWidth (arc length at the layer
+    radius) start at phi = k * 2pi / nPhi, and nZ modules of length moduleLength are centered in nZ equal slices
+    of the layer length. When the modules are narrower (shorter) than the grid pitch the layer has gaps, when they
+    are wider (longer) the neighbouring modules overlap and a point of the overlap is assigned to the module of its
+    grid cell. The module of a point on the layer is found from its grid cell with a single atan2 and no loops.
+*/
+
+#include<TMath.h>
+
+/// @brief Precomputed (phi, z) grid of the modules of one layer
+typedef struct {
+    unsigned int nPhi = 0;      //Modules in phi, 0 for a continuous layer
+    unsigned int nZ = 0;        //Modules in z
+    Double_t phiCellInv = 0.;   //Inverse of the phi pitch
+    Double_t phiActive = 1.;    //Module width in units of the phi pitch (> 1 when the modules overlap)
+    Double_t zMin = 0.;         //Lower edge of the layer
+    Double_t zCellInv = 0.;     //Inverse of the z pitch
+    Double_t zActiveLow = 0.;   //Active range of a z cell, in units of the z pitch
+    Double_t zActiveHigh = 1.;
+    int firstModule = 0;        //Global index of the first module of the layer
+    } ModuleLayout;
+
+namespace ModuleGrid
+{
+    /// @brief Computes the grid of a layer of radius R and half length H
+    /// @param nPhi Modules in phi (0 for a continuous layer, which is a single module)
+    /// @param nZ Modules in z
+    /// @param width Width of a module in the r-phi plane
+    /// @param length Length of a module along the beam axis
+    /// @param firstModule Global index of the first module of the layer
+    inline ModuleLayout BuildLayout(Double_t R, Double_t H, unsigned int nPhi, unsigned int nZ, Double_t width, Double_t length, int firstModule)
+    {
+        ModuleLayout layout;
+        layout.firstModule = firstModule;
+        if (nPhi == 0 || nZ == 0) return layout;
+
+        Double_t phiPitch = 2 * TMath::Pi() / nPhi;
+        Double_t zPitch = 2 * H / nZ;
+
+        layout.nPhi = nPhi;
+        layout.nZ = nZ;
+        layout.phiCellInv = 1. / phiPitch;
+        layout.phiActive = (width / R) / phiPitch;
+        layout.zMin = -H;
+        layout.zCellInv = 1. / zPitch;
+        layout.zActiveLow = 0.5 - 0.5 * length / zPitch;
+        layout.zActiveHigh = 0.5 + 0.5 * length / zPitch;
+        return layout;
+    }
+
+    /// @brief Number of modules of the layer
+    inline int Modules(const ModuleLayout &layout)
+    {
+        return (layout.nPhi == 0) ? 1 : layout.nPhi * layout.nZ;
+    }
+
+    /// @brief Module containing a point of the layer
+    /// @return Global index of the module, -1 if the point is in a gap between the modules
+    inline int FindModule(const ModuleLayout &layout, Double_t x, Double_t y, Double_t z)
+    {
+        if (layout.nPhi == 0) return layout.firstModule;
+
+        Double_t phi = TMath::ATan2(y, x);
+        if (phi < 0) phi += 2 * TMath::Pi();
+
+        Double_t u = phi * layout.phiCellInv;
+        unsigned int i = (unsigned int)u;
+        if (i >= layout.nPhi) i = layout.nPhi - 1; //phi = 2pi after rounding
+        if (u - i >= layout.phiActive) return -1;
+
+        Double_t w = (z - layout.zMin) * layout.zCellInv;
+        if (w < 0 || w > layout.nZ) return -1;
+        unsigned int j = (unsigned int)w;
+        if (j >= layout.nZ) j = layout.nZ - 1; //Layer edge
+        if (w - j < layout.zActiveLow || w - j >= layout.zActiveHigh) return -1;
+
+        return layout.firstModule + j * layout.nPhi + i;
+    }
+}
+
+#endif
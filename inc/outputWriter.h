@@ -0,0 +1,53 @@
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<vector>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+
+#include<TNamed.h>
+
+#include "../inc/eventRecord.h"
+
+/// @brief Writer thread for the simulation output. The simulation moves the EventRecord of each event into a front buffer, while the writer thread fills the PixelTracker TTree from the back buffer: basket compression and flushes to the storage do not stall the event loop.
+class OutputWriter : public TNamed
+{
+    public:
+        /// @param fillFunction Function writing one EventRecord in the output TTree. It is called only by the writer thread, which therefore owns the TTree and the output TFile until Close() returns.
+        /// @param batchSize Number of events collected in the front buffer before it is handed to the writer thread
+        OutputWriter(std::function<void(EventRecord &)> fillFunction, unsigned long int batchSize = 1000);
+        ~OutputWriter();
+
+        /// @brief Hands the output of one event to the writer. It blocks only if both buffers are full.
+        void Submit(EventRecord &&record);
+
+        /// @brief Writes the events still buffered and stops the writer thread
+        void Close();
+
+    private:
+        std::function<void(EventRecord &)> fill;
+        unsigned long int batch;
+
+        std::vector<EventRecord> frontBuffer;
+        std::vector<EventRecord> backBuffer;
+        bool backBufferReady = false;
+        bool stop = false;
+
+        std::mutex bufferMutex;
+        std::condition_variable bufferCondition;
+        std::thread writerThread;
+
+        void SwapBuffers(std::unique_lock<std::mutex> &lock);
+        void WriterLoop();
+};
+
+#endif
@@ -8,12 +8,17 @@
 *   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
 */
 
+#include<atomic>
+#include<vector>
+#include<algorithm>
+
 #include<TNamed.h>
 
 #include "../inc/rndEngine.h"
 #include "../inc/eventManager.h"
 #include "../inc/conf.h"
 #include "../inc/track.h"
+#include "../inc/fastMath.h"
 
 /// @brief This class is intended to be used as a "singleton" that represents the engine generating collision using Monte Carlo distributions
 class ParticleGun : public TNamed
@@ -34,24 +39,50 @@ class ParticleGun : public TNamed
         unsigned long int GetParticleID();
         void ImportConfig(ProgramConfig * conf);
 
+        /// @brief Restart the particle numbering. The counter is shared by all the ParticleGun istances of the run, so that particle IDs stay unique with several worker threads.
+        static void ResetParticleID();
+
     private:
         EventManager * currentEvent;
-        static RndEngine * rndEngine;
+        RndEngine * rndEngine;
+        /// @brief Adds a primary Track to a persistent event
         void GeneratePrimaryTrack(Double_t zpos = 0, Double_t xpos = 0, Double_t ypos = 0, Double_t eta = 0, Double_t azimuth = 0, Double_t momentum = 0, Double_t mass = 0, Double_t charge = 0);
 
-        TH1D * momentumDistribution;
-        TH1D * etaDistribution;
-        TH1D * multiplicityDistribution;
-        TH1D * phiDistribution;
-        TH1D * bunchCrossingX;
-        TH1D * bunchCrossingY;
-        TH1D * zPosDistribution;
+        /// @brief Samples momentum, eta and phi of all the primary particles of a collision in bulk, one distribution at a time
+        void SampleKinematics(unsigned int mult);
+
+        /// @brief Writes the TrackStates of all the primary particles of a collision of a non persistent event, from the kinematics of SampleKinematics
+        void GeneratePrimaries(unsigned int mult, Double_t xpos, Double_t ypos, Double_t zpos);
+        std::vector<Double_t> momenta;  //Kinematics of the particles of the current collision
+        std::vector<Double_t> etas;
+        std::vector<Double_t> phis;
+        std::vector<Double_t> sinThetas;    //Directions of the particles of the current collision
+        std::vector<Double_t> cosThetas;
+        std::vector<Double_t> sinPhis;
+        std::vector<Double_t> cosPhis;
+
+        /// @brief True if a straight line from the vertex with the given polar angle, widened by the acceptance margin, can cross a sensitive layer. The azimuth is not tested, since the layers are full cylinders.
+        bool InAcceptance(Double_t xpos, Double_t ypos, Double_t zpos, Double_t sinTheta, Double_t cosTheta);
+        bool acceptancePrefilter;
+        Double_t sinMargin, cosMargin;
+        std::vector<Double_t> acceptanceRMin;   //Radial extent of each sensitive layer
+        std::vector<Double_t> acceptanceRMax;
+        std::vector<Double_t> acceptanceHalfLength;
+
+        //Input distributions, owned by the ProgramConfig
+        const Distribution1D * momentumDistribution;
+        const Distribution1D * etaDistribution;
+        const Distribution1D * multiplicityDistribution;
+        const Distribution1D * phiDistribution;
+        const Distribution1D * bunchCrossingX;
+        const Distribution1D * bunchCrossingY;
+        const Distribution1D * zPosDistribution;
 
         double mass;
         double charge;
         bool disableKin;
 
-        static unsigned long int particleIDGenerator;
+        static std::atomic<unsigned long int> particleIDGenerator;
 
     #if !defined(__CLING__)
     //ClassDef(ParticleGun, 1);
@@ -59,7 +90,6 @@ class ParticleGun : public TNamed
 };
 
 //Definition of static data members
-RndEngine * ParticleGun::rndEngine;
-unsigned long int ParticleGun::particleIDGenerator;
+std::atomic<unsigned long int> ParticleGun::particleIDGenerator(0);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef RINGQUEUE_H
+#define RINGQUEUE_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<vector>
+#include<atomic>
+#include<thread>
+
+/// @brief Bounded lock-free queue with exactly one producer thread and one consumer thread, used to connect the stages of the simulation pipeline
+template <typename T>
+class RingQueue
+{
+    public:
+        /// @param capacity Maximum number of items in the queue, rounded up to a power of two
+        RingQueue(unsigned long int capacity)
+        {
+            unsigned long int size = 2;
+            while (size < capacity) size *= 2;
+            buffer.resize(size);
+            mask = size - 1;
+            head = 0;
+            tail = 0;
+        }
+
+        ~RingQueue() {}
+
+        /// @brief Non blocking insertion, called only by the producer thread
+        /// @return False if the queue is full
+        bool Push(const T &item)
+        {
+            unsigned long int t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) > mask) return false;
+            buffer[t & mask] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Non blocking extraction, called only by the consumer thread
+        /// @return False if the queue is empty
+        bool Pop(T &item)
+        {
+            unsigned long int h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) return false;
+            item = buffer[h & mask];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        void WaitPush(const T &item) {while (!Push(item)) std::this_thread::yield();}
+        void WaitPop(T &item) {while (!Pop(item)) std::this_thread::yield();}
+
+    private:
+        std::vector<T> buffer;
+        unsigned long int mask;
+
+        //Producer and consumer indices on separate cache lines
+        alignas(64) std::atomic<unsigned long int> head;
+        alignas(64) std::atomic<unsigned long int> tail;
+};
+
+#endif
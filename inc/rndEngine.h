@@ -9,6 +9,9 @@
 */
 
 #include<TRandom3.h>
+#include<TMath.h>
+
+#include "../inc/fastMath.h"
 
 /// @brief This class is a singleton that represents the engine generating collision using Monte Carlo distributions
 class RndEngine : public TRandom3
@@ -16,12 +19,97 @@ class RndEngine : public TRandom3
     public:
         RndEngine();
         ~RndEngine();
+
+        /// @brief Independent random streams inside a single event, one for each stage of the simulation
+        enum RandomStream {kGenerationStream = 0, kTransportStream = 1, kDetectorStream = 2};
+
+        /// @brief Switch between the sequential TRandom3 generator and the counter-based Philox4x32-10 generator. In counter-based mode the numbers depend only on (seed, eventID, stream, draw index), so any event can be regenerated alone, in any order and on any thread or process.
+        /// @param enable Enable the counter-based generator
+        /// @param seed Key of the counter-based generator
+        void SetCounterBased(bool enable, ULong64_t seed = 0);
+        bool IsCounterBased() {return counterBased;}
+
+        /// @brief Restart the counter-based generator at the first draw of the given event and stream. It has no effect on the TRandom3 generator.
+        void SetEventStream(ULong64_t eventID, UInt_t stream);
+
+        /// @brief Position inside a counter-based stream, used to interleave the draws of several events on one engine
+        typedef struct {
+            UInt_t counter[4];
+            UInt_t block[4];
+            unsigned int blockIndex;
+            } StreamState;
+
+        /// @brief Save and restore the position in the current counter-based stream. They have no effect on the TRandom3 generator.
+        void SaveStream(StreamState &state);
+        void RestoreStream(const StreamState &state);
+
+        using TRandom3::Rndm;
+        Double_t Rndm() override;
+        void RndmArray(Int_t n, Float_t * array) override;
+        void RndmArray(Int_t n, Double_t * array) override;
+
+        /// @brief Fills an array with standard normal numbers, with the Box-Muller transform applied to the whole array of uniform numbers of RndmArray
+        void GausArray(Int_t n, Double_t * array);
         
     private:
+        bool counterBased = false;
+        UInt_t key[2] = {0, 0};
+        UInt_t counter[4] = {0, 0, 0, 0};
+        UInt_t block[4] = {0, 0, 0, 0};
+        unsigned int blockIndex = 4;
+
+        void PhiloxBlock();
 
     #if !defined(__CLING__)
     //ClassDef(RndEngine, 1);
     #endif
 };
 
-#endif
\ No newline at end of file
+/// @brief Buffers of uniform and normal random numbers of one event, refilled in bulk from a RndEngine. The buffer keeps its own position in the counter-based stream of the engine, so the buffers of several events can be used in any order.
+class RandomBuffer
+{
+    public:
+        static const unsigned int kSize = 32;
+
+        /// @brief Discards the numbers left in the buffers and starts from the current position of the engine stream
+        void Reset(RndEngine * rndE)
+        {
+            engine = rndE;
+            engine->SaveStream(stream);
+            uniformIndex = kSize;
+            normalIndex = kSize;
+        }
+
+        /// @brief Uniform number in (0, 1), as RndEngine::Rndm
+        Double_t Rndm()
+        {
+            if (uniformIndex == kSize) Refill(uniform, uniformIndex, false);
+            return uniform[uniformIndex++];
+        }
+
+        /// @brief Normal number with the given mean and sigma, as RndEngine::Gaus
+        Double_t Gaus(Double_t mean = 0., Double_t sigma = 1.)
+        {
+            if (normalIndex == kSize) Refill(normal, normalIndex, true);
+            return mean + sigma * normal[normalIndex++];
+        }
+
+    private:
+        RndEngine * engine = nullptr;
+        RndEngine::StreamState stream;
+        Double_t uniform[kSize];
+        Double_t normal[kSize];
+        unsigned int uniformIndex = kSize;
+        unsigned int normalIndex = kSize;
+
+        void Refill(Double_t * array, unsigned int &index, bool gaussian)
+        {
+            engine->RestoreStream(stream);
+            if (gaussian) engine->GausArray(kSize, array);
+            else engine->RndmArray(kSize, array);
+            engine->SaveStream(stream);
+            index = 0;
+        }
+};
+
+#endif
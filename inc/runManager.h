@@ -11,6 +11,10 @@
 #include<vector>
 #include<string>
 #include<iostream>
+#include<thread>
+#include<mutex>
+#include<atomic>
+#include<functional>
 
 #include<TSystem.h>
 #include<TNamed.h>
@@ -19,13 +23,24 @@
 #include<TBranch.h>
 #include<TFile.h>
 #include<TStopwatch.h>
+#include<TROOT.h>
 
+#include "../inc/eventRecord.h"
+#include "../inc/ringQueue.h"
+#include "../inc/outputWriter.h"
 #include "../inc/eventManager.h"
 #include "../inc/particleGun.h"
 #include "../inc/experimentSimulation.h"
 #include "../inc/conf.h"
 #include "../inc/detectorEffects.h"
 
+/// @brief Simulation objects owned by a single worker thread. Nothing in here is shared with the other workers.
+typedef struct{
+    RndEngine * rndEngine;
+    ParticleGun * particleGun;
+    ExperimentSimulation * experimentSimulation;
+    DetectorEffects * detectorEffects;
+    } SimulationWorker;
 
 /// @brief This class contains the settings, output and data analysis of single run
 class RunManager : public TTree
@@ -45,6 +60,9 @@ class RunManager : public TTree
         ExperimentSimulation * GetExperimentSimulation() {return experimentSimulation;}
         EventManager * GetEvent(unsigned long int index) {return events[index];}
 
+        /// @brief Copies one EventRecord in the TTree branches and flushes the TTree periodically. It is called by the OutputWriter thread when the asynchronous output is enabled.
+        void FillRecord(EventRecord &record);
+
     private:
         TFile * simCurrentFile;
         ProgramConfig * conf;
@@ -56,33 +74,52 @@ class RunManager : public TTree
         std::vector<EventManager *> events;
         MemInfo_t memInfo;
 
+        //Worker 0 is built on the objects above, the others are allocated only for multi-threaded runs
+        std::vector<SimulationWorker> workers;
+        std::atomic<unsigned long int> nextEvent;
+        unsigned long int committedEvents = 0;
+        unsigned long int writtenEvents = 0;
+        unsigned long int writtenPrimaries = 0;     //Truth count of the acceptance prefilter, filled with the TTree
+        unsigned long int rejectedPrimaries = 0;
+        std::mutex commitMutex;
+        OutputWriter * outputWriter = nullptr;
+
         void SimulationBackend();
+        void AllocateWorkers(unsigned int nWorkers);
+        void FreeWorkers();
+        void WorkerLoop(unsigned int workerIndex);
 
-};
+        //Pipelined mode: one generation stage, nStages transport stages and the output stage on the calling thread
+        void PipelineBackend(unsigned int nStages);
+        void GenerationStage(std::vector<RingQueue<EventManager *> *> &transportQueues);
+        void TransportStage(unsigned int workerIndex, RingQueue<EventManager *> * inQueue, RingQueue<EventManager *> * outQueue);
 
-//Definition of static data members
-RndEngine * RunManager::rndEngine;
+        /// @brief Generates and transports a single event using only the objects owned by the given worker
+        /// @param worker Worker that will process the event
+        /// @param eventID Identifier of the event, fixed by the caller so that it does not depend on the thread scheduling
+        EventManager * SimulateEvent(SimulationWorker &worker, Int_t eventID);
 
-typedef struct{
-    Double_t X;
-    Double_t Y;
-    Double_t Z;
-    Int_t mult;
-    Int_t eventID;
-    } Vertex;
+        /// @brief Generates and transports the events with IDs firstEventID ... firstEventID + nEvents - 1, with the batched transport when the block has more than one event
+        /// @param block Output vector with the simulated events, in order of event ID
+        void SimulateBlock(SimulationWorker &worker, Int_t firstEventID, unsigned int nEvents, std::vector<EventManager *> &block);
 
-typedef struct{
-    Double_t X;
-    Double_t Y;
-    Double_t Z;
-    ULong64_t eventID;
-    ULong64_t particleID;
-    ULong64_t detectorID;
-    } DetHit;
+        //The two halves of SimulateEvent, used separately by the pipeline stages
+        EventManager * GenerateEvent(SimulationWorker &worker, Int_t eventID);
+        void TransportEvent(SimulationWorker &worker, EventManager * currentEvent);
+        void ApplyDetectorEffects(SimulationWorker &worker, EventManager * currentEvent);
+
+        unsigned int GetBlockSize();
 
+        /// @brief Hands the EventRecord of the event to the output (writer thread or direct TTree filling) and stores or deallocates the event. It must be called by one thread at a time.
+        void CommitEvent(EventManager * currentEvent);
+
+};
+
+//Definition of static data members
+RndEngine * RunManager::rndEngine;
 
 //These are globals used to access the TTrees
 Vertex vert;
 DetHit dhit;
 
-#endif
\ No newline at end of file
+#endif
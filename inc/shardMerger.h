@@ -0,0 +1,45 @@
+#ifndef SHARDMERGER_H
+#define SHARDMERGER_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<string>
+#include<cstring>
+#include<iostream>
+
+#include<TNamed.h>
+#include<TFile.h>
+#include<TTree.h>
+#include<TBranch.h>
+#include<TKey.h>
+
+#include "../inc/conf.h"
+#include "../inc/eventRecord.h"
+
+/// @brief This class merges the output files of a sharded simulation into a single PixelTracker TTree that can be passed to the vertex reconstruction
+class ShardMerger : public TNamed
+{
+    public:
+        ShardMerger(ProgramConfig * config);
+        ~ShardMerger();
+
+        /// @brief Reads the shard files in order and writes their content in the file given by simRootFileName. Event IDs are checked to be contiguous and particle IDs are shifted so that they are unique in the merged run.
+        /// @return True if all the shards were found and their event ID ranges are contiguous
+        bool Merge();
+
+    private:
+        ProgramConfig * conf;
+        TTree * outTree;
+        Vertex outVert;
+        DetHit outHit;
+        ULong64_t particleIDOffset = 0;
+
+        bool MergeShard(TFile * shardFile, unsigned int index);
+};
+
+#endif
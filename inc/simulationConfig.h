@@ -131,6 +131,7 @@
 
 #include "Riostream.h"
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <TF1.h>
 #include <TF2.h>
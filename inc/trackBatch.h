@@ -0,0 +1,77 @@
+#ifndef TRACKBATCH_H
+#define TRACKBATCH_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<vector>
+#include<TObject.h>
+
+#include "../inc/transportReal.h"
+
+/// @brief Structure of arrays with the active tracks of a block of events, used by the batched transport. Each track is a straight segment starting at (x0, y0, z0) with unit direction (dx, dy, dz).
+class TrackBatch
+{
+    public:
+        std::vector<TransportReal> x0, y0, z0;      //Start point of the current segment
+        std::vector<TransportReal> dx, dy, dz;      //Unit direction
+        std::vector<TransportReal> p;               //Momentum norm
+        std::vector<TransportReal> speed;           //Velocity norm, the intersection times are in seconds as in GetGeomIntersection
+        std::vector<unsigned int> eventIndex;       //Index of the event inside the block
+        std::vector<ULong64_t> particleID;
+        std::vector<int> nextLayer;                 //Index in the layer table of the first layer that can be crossed
+
+        //Output of the intersection kernel
+        std::vector<TransportReal> tHit;            //Time of the first intersection
+        std::vector<int> layer;                     //Index in the layer table of the intersected layer, -1 if none
+
+        unsigned long int Size() const {return x0.size();}
+
+        void Clear()
+        {
+            Resize(0);
+        }
+
+        void Reserve(unsigned long int n)
+        {
+            x0.reserve(n); y0.reserve(n); z0.reserve(n);
+            dx.reserve(n); dy.reserve(n); dz.reserve(n);
+            p.reserve(n); speed.reserve(n);
+            eventIndex.reserve(n); particleID.reserve(n); nextLayer.reserve(n);
+            tHit.reserve(n); layer.reserve(n);
+        }
+
+        void Resize(unsigned long int n)
+        {
+            x0.resize(n); y0.resize(n); z0.resize(n);
+            dx.resize(n); dy.resize(n); dz.resize(n);
+            p.resize(n); speed.resize(n);
+            eventIndex.resize(n); particleID.resize(n); nextLayer.resize(n);
+            tHit.resize(n); layer.resize(n);
+        }
+
+        void Push(Double_t x, Double_t y, Double_t z, Double_t ux, Double_t uy, Double_t uz, Double_t momentum, Double_t v, unsigned int event, ULong64_t particle, int next)
+        {
+            x0.push_back(x); y0.push_back(y); z0.push_back(z);
+            dx.push_back(ux); dy.push_back(uy); dz.push_back(uz);
+            p.push_back(momentum); speed.push_back(v);
+            eventIndex.push_back(event); particleID.push_back(particle); nextLayer.push_back(next);
+            tHit.push_back(1.); layer.push_back(-1);
+        }
+
+        /// @brief Copies the track in position src to position dst, used to compact the active tracks in place
+        void Move(unsigned long int src, unsigned long int dst)
+        {
+            x0[dst] = x0[src]; y0[dst] = y0[src]; z0[dst] = z0[src];
+            dx[dst] = dx[src]; dy[dst] = dy[src]; dz[dst] = dz[src];
+            p[dst] = p[src]; speed[dst] = speed[src];
+            eventIndex[dst] = eventIndex[src]; particleID[dst] = particleID[src]; nextLayer[dst] = nextLayer[src];
+            tHit[dst] = tHit[src]; layer[dst] = layer[src];
+        }
+};
+
+#endif
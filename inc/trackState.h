@@ -0,0 +1,51 @@
+#ifndef TRACKSTATE_H
+#define TRACKSTATE_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<TMath.h>
+
+#include "../inc/units.h"
+#include "../inc/transportReal.h"
+
+/// @brief Compact state of a particle used by the transport of non persistent events. Differently from Track it is not a TObject, and the quantities read by the transport (direction, |p|, relativistic factors) are computed once when the particle is generated: the multiple scattering changes only the direction.
+typedef struct {
+    TransportReal x0, y0, z0;   //Start point of the current segment
+    TransportReal dx, dy, dz;   //Unit direction
+    TransportReal p;            //Momentum norm
+    TransportReal betaGamma;    //p / (m c)
+    TransportReal beta;
+    TransportReal speed;        //Velocity norm (beta * c), the intersection times are in seconds
+    ULong64_t particleID;
+    unsigned int nextLayer; //Index in the layer table of the first layer that can be crossed
+    bool active;
+    } TrackState;
+
+/// @brief Fills the state of a particle with given start point, unit direction, momentum norm and mass
+inline void InitTrackState(TrackState &state, Double_t x, Double_t y, Double_t z, Double_t ux, Double_t uy, Double_t uz, Double_t momentum, Double_t mass, ULong64_t particleID)
+{
+    state.x0 = x;
+    state.y0 = y;
+    state.z0 = z;
+    state.dx = ux;
+    state.dy = uy;
+    state.dz = uz;
+    state.p = momentum;
+
+    //Same relations of Track::GetGamma, GetBeta and GetVelocity
+    Double_t gamma = TMath::Sqrt(1 + momentum * momentum / (mass * mass * (Units::c * Units::c)));
+    state.betaGamma = momentum / (mass * Units::c);
+    state.beta = TMath::Sqrt(1 - 1. / (gamma * gamma));
+    state.speed = momentum / (gamma * mass);
+
+    state.particleID = particleID;
+    state.nextLayer = 0;
+    state.active = true;
+}
+
+#endif
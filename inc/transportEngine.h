@@ -8,6 +8,8 @@
 *   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
 */
 
+#include<iostream>
+
 #include<TObject.h>
 #include<TVector3.h>
 #include<TMath.h>
@@ -16,6 +18,7 @@
 
 #include "../inc/track.h"
 #include "../inc/rndEngine.h"
+#include "../inc/fastMath.h"
 
 /// @brief This static class implements particle transport through the materials of the detector
 class TransportEngine : public TObject
@@ -30,14 +33,53 @@ class TransportEngine : public TObject
         //Multiple scattering process
         /// @brief This functions is used to model the multiple scattering effect between high energy charged particles and thin layers of materials. It uses the Highland formula to compute the average theta scattering angle and it performs coordinate transformations. (https://doi.org/10.1016/0168-583X(91)95671-Y)
         /// @param incomingTrack Pointer to the incoming track. After interacting with the layer of material, the track "Active" attribute will be turned to false and the tracking is stopped.
-        /// @param outgoingTrack Pointer to the outgoing active track.
+        /// @param outgoingTrack Pointer to the outgoing active track. It can be the incoming track itself, which is then updated in place.
         /// @param interactionPoint Hit object that represents the point of interaction between the track and the material.
-        /// @param zMat Z of the material
-        /// @param x Tickness of the material
-        /// @param xr Radiation length of the material
+        /// @param highlandConstant Material constant of the layer for the Highland formula, see HighlandConstant
         /// @param thetaMsAp Enable the zero order approximation of the theta angle (=1 mrad), instead of the Highland formula, for rough and fast simulations
         /// @param kinematics Enable the relativistic kinematics calulations. If false, only geometric trajectory tracking is performed.
-        static void MultipleScattering(Track * incomingTrack, Track * &outgoingTrack, TVector3 * interactionPoint, Int_t zMat, Double_t x, Double_t xr, bool thetaMsAp = true, bool kinematics = true);
+        /// @param random Random numbers of the current event of the calling worker thread. If not given, they are drawn from the engine set with SetRandomEngine.
+        static void MultipleScattering(Track * incomingTrack, Track * &outgoingTrack, TVector3 * interactionPoint, Double_t highlandConstant, bool thetaMsAp = true, bool kinematics = true, RandomBuffer * random = nullptr);
+
+        /// @brief Multiple scattering on a unit direction vector, without Track objects. It draws the same random numbers, in the same order, as MultipleScattering.
+        /// @param dx Direction x component, overwritten with the outgoing direction
+        /// @param dy Direction y component, overwritten with the outgoing direction
+        /// @param dz Direction z component, overwritten with the outgoing direction
+        /// @param theta0 Width of the gaussian distribution of the scattering angle
+        /// @param random RandomBuffer of the current event, or random engine
+        template<typename Random>
+        static void ScatterDirection(Double_t &dx, Double_t &dy, Double_t &dz, Double_t theta0, Random * random)
+        {
+            Double_t phiP = random->Rndm() * 2*Units::pi;
+            Double_t thetaP = random->Gaus(0., theta0);
+
+            RotateDirection(dx, dy, dz, thetaP, phiP);
+        }
+
+        /// @brief Rotates a unit direction by the scattering angles (thetaP, phiP), defined in the local frame of the direction. The frame is built from the direction components: one sincos evaluation for the azimuth and the small angle series (FastMath::SinCosSmall) for the scattering angle.
+        static void RotateDirection(Double_t &dx, Double_t &dy, Double_t &dz, Double_t thetaP, Double_t phiP);
+
+        /// @brief Reference implementation of RotateDirection: recovers theta and phi of the direction and applies the rotation matrix of Rotate
+        static void RotateDirectionAngles(Double_t &dx, Double_t &dy, Double_t &dz, Double_t thetaP, Double_t phiP);
+
+        /// @brief Compares RotateDirection with the reference implementation on isotropic directions: maximum difference of the outgoing directions for the same angles, and Kolmogorov test of the outgoing theta and deflection angle distributions
+        /// @return True if the two implementations agree
+        static bool ValidateRotation(unsigned long int nSamples, Double_t theta0, RndEngine * rndE = nullptr);
+
+        /// @brief Highland formula for the width of the multiple scattering angle
+        /// @param zMat Charge number of the particle
+        /// @param x Tickness of the material
+        /// @param xr Radiation length of the material
+        static Double_t HighlandTheta0(Double_t beta, Double_t momentum, Int_t zMat, Double_t x, Double_t xr);
+
+        /// @brief Highland formula with the constant of the layer computed by HighlandConstant: one multiplication and one division
+        static Double_t HighlandTheta0(Double_t beta, Double_t momentum, Double_t highlandConstant) {return highlandConstant / (beta * momentum);}
+
+        /// @brief Part of the Highland formula that depends only on the layer and on the particle charge, 13.6 MeV/c * z * sqrt(x/X0) * (1 + 0.038 ln(x/X0)). It is zero for layers without material.
+        /// @param zMat Charge number of the particle
+        /// @param x Tickness of the material
+        /// @param xr Radiation length of the material
+        static Double_t HighlandConstant(Int_t zMat, Double_t x, Double_t xr);
 
         //Bethe-Bloch equation ionization (NOT YET IMPLEMENTED!)
         static void Ionization(Track * incomingTrack, Track * outgoingTrack);
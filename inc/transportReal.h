@@ -0,0 +1,25 @@
+#ifndef TRANSPORTREAL_H
+#define TRANSPORTREAL_H
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<TObject.h>
+
+/*
+    Floating point type of the transport of non persistent events (TrackState, TrackBatch and the batched
+    intersection kernel). Compiling with -DTANS_SINGLE_PRECISION (start.cxx option "float") the transport runs
+    in single precision: the SIMD kernel processes twice as many tracks per instruction and the track arrays
+    are half the size. Track, Hit and the output DetHit stay in double precision.
+*/
+#ifdef TANS_SINGLE_PRECISION
+typedef Float_t TransportReal;
+#else
+typedef Double_t TransportReal;
+#endif
+
+#endif
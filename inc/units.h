@@ -12,55 +12,63 @@
 *   The numerical values in this simple Monte Carlo simulation & reconstruction tools
 *   are always represented in International System MKS units. This header file contains
 *   definitions of units and contants
+*
+*   The units are compile time constants of the namespace Units, so the expressions made only of units
+*   (e.g. 13.6 * Units::MeV / Units::c) are folded by the compiler. The names are not imported in the global
+*   scope, since the single letter ones (m, c, e, s...) would clash with local variables and ROOT identifiers:
+*   use the qualified names, or a using-directive inside the function that needs many of them.
 */
 
-Double_t    kg  = 1;
-Double_t    g   = 0.001 * kg;
-Double_t    mg  = 0.001 * g;
-Double_t    ug  = 0.001 * mg;
+namespace Units
+{
+    constexpr Double_t    kg  = 1;
+    constexpr Double_t    g   = 0.001 * kg;
+    constexpr Double_t    mg  = 0.001 * g;
+    constexpr Double_t    ug  = 0.001 * mg;
 
-Double_t    m   = 1;
-Double_t    km  = 1000 * m;
-Double_t    cm  = 0.01  * m;
-Double_t    mm  = 0.001 * m;
-Double_t    um  = 0.001 * mm;
-Double_t    nm  = 0.001 * um;
+    constexpr Double_t    m   = 1;
+    constexpr Double_t    km  = 1000 * m;
+    constexpr Double_t    cm  = 0.01  * m;
+    constexpr Double_t    mm  = 0.001 * m;
+    constexpr Double_t    um  = 0.001 * mm;
+    constexpr Double_t    nm  = 0.001 * um;
 
-Double_t    s   = 1;
-Double_t    ms  = 0.001 * s;
-Double_t    us  = 0.001 * ms;
-Double_t    ns  = 0.001 * us;
-Double_t    ps  = 0.001 * ns;
+    constexpr Double_t    s   = 1;
+    constexpr Double_t    ms  = 0.001 * s;
+    constexpr Double_t    us  = 0.001 * ms;
+    constexpr Double_t    ns  = 0.001 * us;
+    constexpr Double_t    ps  = 0.001 * ns;
 
-Double_t    V   = 1;
-Double_t    mV  = 0.001 * V;
-Double_t    kV  = 1000 * V;
+    constexpr Double_t    V   = 1;
+    constexpr Double_t    mV  = 0.001 * V;
+    constexpr Double_t    kV  = 1000 * V;
 
-Double_t    T   = 1;
-Double_t    mT  = 0.001 * T;
-Double_t    uT  = 0.001 * mT;
+    constexpr Double_t    T   = 1;
+    constexpr Double_t    mT  = 0.001 * T;
+    constexpr Double_t    uT  = 0.001 * mT;
 
-Double_t    A   = 1;
-Double_t    kA  = 1000 * A;
-Double_t    mA  = 0.001 * A;
-Double_t    uA  = 0.001 * mA;
-Double_t    nA  = 0.001 * uA;
+    constexpr Double_t    A   = 1;
+    constexpr Double_t    kA  = 1000 * A;
+    constexpr Double_t    mA  = 0.001 * A;
+    constexpr Double_t    uA  = 0.001 * mA;
+    constexpr Double_t    nA  = 0.001 * uA;
 
-Double_t    C   = 1;
-Double_t    mC  = 0.001 * C;
-Double_t    uC  = 0.001 * mC;
-Double_t    pC  = 0.001 * uC;
-Double_t    fC  = 0.001 * pC;
+    constexpr Double_t    C   = 1;
+    constexpr Double_t    mC  = 0.001 * C;
+    constexpr Double_t    uC  = 0.001 * mC;
+    constexpr Double_t    pC  = 0.001 * uC;
+    constexpr Double_t    fC  = 0.001 * pC;
 
-Double_t    c   = 299792458 * m / s;
-Double_t    e   = 1.60217663e-19 * C;
-Double_t    h   = 6.62607015e-34 * kg * m * m / s;
-Double_t    pi  = 3.1415926535;
-Double_t    eV  = e * V;
+    constexpr Double_t    c   = 299792458 * m / s;
+    constexpr Double_t    e   = 1.60217663e-19 * C;
+    constexpr Double_t    h   = 6.62607015e-34 * kg * m * m / s;
+    constexpr Double_t    pi  = 3.1415926535;
+    constexpr Double_t    eV  = e * V;
 
-Double_t    keV = 1000 * eV;
-Double_t    MeV = 1000 * keV;
-Double_t    GeV = 1000 * MeV;
-Double_t    TeV = 1000 * GeV;
+    constexpr Double_t    keV = 1000 * eV;
+    constexpr Double_t    MeV = 1000 * keV;
+    constexpr Double_t    GeV = 1000 * MeV;
+    constexpr Double_t    TeV = 1000 * GeV;
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -265,34 +265,30 @@ void simulationConfigForm::assign()
 
     if(strcmp(chooseDistName->GetText(), "<default>") == 0) chooseDistName->SetText(def.c_str());
 
-    if (selPDF != 8)
+    //The distributions defined by parameters are written in the configuration file and sampled directly by the simulation, without binning
+    std::string parametric = "";
+    if (temp1dAssigned || temp2dAssigned)
     {
-        TFile * rootfile = new TFile(fTextEntry661->GetText(), "UPDATE");
-        if(!rootfile->IsOpen())
+        std::ostringstream definition;
+        definition.precision(17);
+        switch(selPDF)
         {
-            std::cerr << "\nERROR while opening / creating the input ROOT file!";
-            return;
+            case 1: definition << "uniform(" << par0->GetNumber() << "," << par1->GetNumber() << ")"; break;
+            case 2: definition << "gaus(" << par0->GetNumber() << "," << par1->GetNumber() << ")"; break;
+            case 3: definition << "poisson(" << par0->GetNumber() << ")"; break;
+            case 4: definition << "fixed(" << par0->GetNumber() << ")"; break;
+            case 5: definition << "uniform(" << par0->GetNumber() << "," << par1->GetNumber() << "," << par2->GetNumber() << "," << par3->GetNumber() << ")"; break;
+            case 6: definition << "gaus(" << par0->GetNumber() << "," << par1->GetNumber() << "," << par2->GetNumber() << "," << par3->GetNumber() << ")"; break;
+            case 7: definition << "fixed(" << par0->GetNumber() << "," << par1->GetNumber() << ")"; break;
         }
-        if(temp1dAssigned)
-        {
-            std::cerr << "\nWriting TObject to input TFile...\n";
-            if(!rootfile->FindObject(chooseDistName->GetText()))
-                temp1d->Write(chooseDistName->GetText());
-        }
-        else
-        {
-            if(temp2dAssigned)
-            {
-                std::cerr << "\nWriting TObject to input TFile...\n";
-                if(!rootfile->FindObject(chooseDistName->GetText()))
-                    temp2d->Write(chooseDistName->GetText());
-            }
-        }
-
-        rootfile->Close();
+        parametric = definition.str();
     }
 
-    configurationFileEntry = configurationFileEntry + "=" + std::string(chooseDistName->GetText());
+    //The other distributions are histograms already saved in the input TFile, referenced by name
+    if (parametric != "")
+        configurationFileEntry = configurationFileEntry + "=" + parametric;
+    else
+        configurationFileEntry = configurationFileEntry + "=" + std::string(chooseDistName->GetText());
     configurationFileContent = configurationFileContent + "\n" + configurationFileEntry;
     std::cerr << "\n\nProbability density function assigned.";
     temp1dAssigned = false;
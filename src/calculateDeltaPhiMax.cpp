@@ -48,7 +48,7 @@ double CalculateDeltaPhiMax::ObtainDeltaPhiMax(TFile * simFile){
                               X1=dhit.X;
                               Y1=dhit.Y;
                               double phi1;
-                              phi1=TMath::ATan(X1/Y1);
+                              phi1=FastMath::Atan(X1/Y1);
                               if(X1<0) phi1=phi1+TMath::Pi();
                               else if (X1>0 && Y1<0) phi1=phi1 + 2*TMath::Pi();
                               vecPhi1.push_back(phi1);
@@ -57,7 +57,7 @@ double CalculateDeltaPhiMax::ObtainDeltaPhiMax(TFile * simFile){
                               X2=dhit.X;
                               Y2=dhit.Y;
                               double phi2;
-                              phi2=TMath::ATan(X2/Y2);
+                              phi2=FastMath::Atan(X2/Y2);
                               if(X2<0) phi2=phi2+TMath::Pi();
                               else if (X2>0 && Y2<0) phi2=phi2 + 2*TMath::Pi();  
                               vecPhi2.push_back(phi2);                            
@@ -28,6 +28,23 @@ Cli::~Cli()
 void Cli::Start(TString params, TString configurationFilePath)
 {
     //Parsing arguments....
+    if(params.Contains("shard="))
+    {
+        //Option "shard=k/N": simulate only the k-th of N parts of the run
+        std::string opt(params.Data());
+        sscanf(opt.substr(opt.find("shard=")).c_str(), "shard=%u/%u", &shardIndex, &nShards);
+    }
+
+    if(params.Contains("msval"))
+    {
+        //Multiple scattering rotation compared with the reference implementation, with small and large scattering angles
+        RndEngine * rndE = new RndEngine();
+        bool passed = TransportEngine::ValidateRotation(1000000, 0.001, rndE) && TransportEngine::ValidateRotation(1000000, 0.1, rndE);
+        std::cerr << (passed ? "\nValidation passed.\n\n" : "\nValidation FAILED.\n\n");
+        delete rndE;
+        return;
+    }
+
     if(params.Contains("sim"))
     {
         if(params.Contains("persist"))
@@ -67,6 +84,7 @@ RunManager * Cli::Simulation(TString configurationFilePath = "nn", bool persist
             conf->ReadConfigurationFile();
             if (persist) conf->singleEventPersistenceEnabled = persist;
         }
+        if (nShards > 1) conf->SetShard(shardIndex, nShards);
         configAllocated = true;
     }
     else
@@ -81,7 +99,7 @@ RunManager * Cli::Simulation(TString configurationFilePath = "nn", bool persist
     if(currentRunAllocated) delete currentRun;
 
     //Setup a TFile
-    auto * simCurrentFile = new TFile(conf->simRootFileName.c_str(),"recreate");
+    auto * simCurrentFile = new TFile(conf->GetShardFileName(conf->shardIndex).c_str(),"recreate");
     //simCurrentFile->SetCompressionSettings(50.);
     //simCurrentFile->SetBufferSize(1000000);
     simCurrentFile->cd();
@@ -146,3 +164,155 @@ EventDisplay * Cli::DrawEvent(unsigned long int eventID)
     ed->DrawEvent();
     return ed;
 }
+
+
+bool Cli::ShardedSimulation(TString configurationFilePath, unsigned int nShards)
+{
+    std::cerr << "\n\n\033[1mSharded simulation: " << nShards << " processes.\033[0m\n";
+
+    //The libraries are already compiled by this process, the shards only load them
+    std::string command = "(";
+    for (unsigned int k = 0; k < nShards; ++k)
+    {
+        std::string shard = std::to_string(k) + "/" + std::to_string(nShards);
+        command += "root -l -b -q 'start.cxx(\"sim shard=" + shard + "\", \"" + std::string(configurationFilePath.Data()) + "\")'";
+        command += " > ./shard" + std::to_string(k) + ".log 2>&1 & ";
+    }
+    command += "wait)";
+
+    std::cerr << "\n" << command << "\n";
+    gSystem->Exec(command.c_str());
+
+    return MergeShards(configurationFilePath, nShards);
+}
+
+bool Cli::MergeShards(TString configurationFilePath, unsigned int nShards)
+{
+    if (!configAllocated)
+    {
+        conf = new ProgramConfig();
+        conf->LoadDebugData();
+        if (!gSystem->AccessPathName(configurationFilePath))
+        {
+            conf->SetFilename(std::string(configurationFilePath.Data()));
+            conf->ReadConfigurationFile();
+        }
+        configAllocated = true;
+    }
+    conf->SetShard(0, nShards);
+
+    ShardMerger * merger = new ShardMerger(conf);
+    bool status = merger->Merge();
+    delete merger;
+    return status;
+}
+
+bool Cli::ComparePrecision(TString configurationFilePath)
+{
+    if (!configAllocated)
+    {
+        conf = new ProgramConfig();
+        conf->LoadDebugData();
+        if (!gSystem->AccessPathName(configurationFilePath))
+        {
+            conf->SetFilename(std::string(configurationFilePath.Data()));
+            conf->ReadConfigurationFile();
+        }
+        configAllocated = true;
+    }
+
+    std::cerr << "\n\n\033[1mPrecision comparison: double and single precision transport.\033[0m\n";
+    if (!conf->counterBasedRandom)
+        std::cerr << "\nWarning: without counterBasedRandom=1 a different number of draws in one event changes all the following events.";
+
+    //Same configuration and seed, the output of each run is renamed before the next one
+    std::string output = conf->simRootFileName;
+    std::string base = output.substr(0, output.rfind(".root"));
+    std::string precision[2] = {"double", "float"};
+    std::string options[2] = {"sim", "sim float"};
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+        std::string command = "root -l -b -q 'start.cxx(\"" + options[k] + "\", \"" + std::string(configurationFilePath.Data()) + "\")' > ./precision_" + precision[k] + ".log 2>&1";
+        std::cerr << "\n" << command << "\n";
+        gSystem->Exec(command.c_str());
+        gSystem->Rename(output.c_str(), (base + "_" + precision[k] + ".root").c_str());
+    }
+
+    return CompareHits((base + "_double.root").c_str(), (base + "_float.root").c_str());
+}
+
+bool Cli::CompareHits(TString referenceFileName, TString testFileName)
+{
+    typedef std::tuple<ULong64_t, ULong64_t, ULong64_t> HitKey;
+    std::map<HitKey, DetHit> hits[2];
+    TString fileNames[2] = {referenceFileName, testFileName};
+
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+        TFile * file = new TFile(fileNames[k], "read");
+        if (file->IsZombie())
+        {
+            std::cerr << "\nError: cannot open " << fileNames[k];
+            delete file;
+            return false;
+        }
+
+        DetHit inHit;
+        char ttreeName[60];
+        for (int l = 1; ; l++)
+        {
+            sprintf(ttreeName,"PixelTracker;%d",l);
+            TTree * tree = (TTree*)file->Get(ttreeName);
+            if (tree == nullptr) break;
+
+            TBranch * branchHits = tree->GetBranch("DetectorHits");
+            branchHits->SetAddress(&inHit.X);
+            Long64_t nh = branchHits->GetEntries();
+            for (Long64_t j = 0; j < nh; ++j)
+            {
+                branchHits->GetEntry(j);
+                if (inHit.particleID == 0) continue;
+                hits[k][HitKey(inHit.eventID, inHit.particleID, inHit.detectorID)] = inHit;
+            }
+            delete tree;
+        }
+
+        file->Close();
+        delete file;
+    }
+
+    //Residuals along z and in the transverse plane (r-phi) of the matched hits
+    unsigned long int matched = 0, onlyReference = 0;
+    Double_t sumZ = 0., sumZ2 = 0., maxZ = 0., sumT = 0., sumT2 = 0., maxT = 0.;
+    for (auto it = hits[0].begin(); it != hits[0].end(); ++it)
+    {
+        auto other = hits[1].find(it->first);
+        if (other == hits[1].end())
+        {
+            onlyReference++;
+            continue;
+        }
+        matched++;
+
+        Double_t dz = TMath::Abs(other->second.Z - it->second.Z);
+        Double_t dt = TMath::Sqrt(TMath::Power(other->second.X - it->second.X, 2) + TMath::Power(other->second.Y - it->second.Y, 2));
+        sumZ += dz;
+        sumZ2 += dz * dz;
+        maxZ = TMath::Max(maxZ, dz);
+        sumT += dt;
+        sumT2 += dt * dt;
+        maxT = TMath::Max(maxT, dt);
+    }
+    unsigned long int onlyTest = hits[1].size() - matched;
+
+    std::cout << "\nHits compared: " << referenceFileName << " (reference)  vs  " << testFileName;
+    std::cout << "\n   Matched hits: " << matched << "   only in reference: " << onlyReference << "   only in test: " << onlyTest;
+    if (matched > 0)
+    {
+        std::cout << "\n   |dZ|   mean = " << sumZ / matched << " m   rms = " << TMath::Sqrt(sumZ2 / matched) << " m   max = " << maxZ << " m";
+        std::cout << "\n   |dXY|  mean = " << sumT / matched << " m   rms = " << TMath::Sqrt(sumT2 / matched) << " m   max = " << maxT << " m";
+    }
+    std::cout << "\n";
+
+    return true;
+}
@@ -54,6 +54,7 @@ void ProgramConfig::ReadConfigurationFile()
 
     std::string line;
     bool confReadStatus = false;
+    layerKeys.clear();
     std::cerr << "\n";
 
     while(std::getline(fileStream, line))
@@ -82,6 +83,8 @@ void ProgramConfig::ReadConfigurationFile()
 
     if(!confReadStatus) std::cerr << "\nCritical error while reading configuration file!"; else std::cerr << "\nInitialization completed.";
 
+    BuildLayers();
+
     
 }
 
@@ -92,6 +95,7 @@ bool ProgramConfig::IsInit()
 
 void ProgramConfig::LoadDebugData()
 {
+    using namespace Units;
     bool debug = true;
     std::cerr << "\nLoading default values...";
     
@@ -238,12 +242,64 @@ void ProgramConfig::LoadDebugData()
     enableHitGaussianSmearing = true;
     enableSoftParticlesNoise = true;
     singleEventPersistenceEnabled = false;
+
+    BuildLayers();
+}
+
+void ProgramConfig::AddLayer(std::string value)
+{
+    std::stringstream valuestream(value);
+    std::vector<std::string> fields;
+    std::string field;
+    while(std::getline(valuestream, field, ','))
+        fields.push_back(field);
+
+    if (fields.size() != 5 && fields.size() != 9)
+    {
+        std::cerr << "\nError: layer=" << value << " is not in the format radius,thickness,length,material,sensitive[,nPhiModules,nZModules,moduleWidth,moduleLength]. Layer ignored.";
+        return;
+    }
+
+    LayerConfig layer = {};
+    layer.radius = atof(fields[0].c_str());
+    layer.thickness = atof(fields[1].c_str());
+    layer.length = atof(fields[2].c_str());
+    layer.material = fields[3];
+    layer.sensitive = (bool)atoi(fields[4].c_str());
+
+    //Optional segmentation in pixel modules
+    if (fields.size() == 9)
+    {
+        layer.nPhiModules = atoi(fields[5].c_str());
+        layer.nZModules = atoi(fields[6].c_str());
+        layer.moduleWidth = atof(fields[7].c_str());
+        layer.moduleLength = atof(fields[8].c_str());
+    }
+    layerKeys.push_back(layer);
+}
+
+void ProgramConfig::BuildLayers()
+{
+    if (layerKeys.size() > 0)
+    {
+        layers = layerKeys;
+        return;
+    }
+
+    //Legacy configuration: beam pipe and two silicon layers (detectorID 0, 1, 2)
+    layers.clear();
+    layers.push_back({beamPipeRadius, beamPipeTickness, beamPipeLenght, "Berillium", false});
+    layers.push_back({innerSiliconRadius, siliconTickness, innerSiLenght, "Silicon", true});
+    layers.push_back({outerSiliconRadius, siliconTickness, outerSiLenght, "Silicon", true});
 }
 
 void ProgramConfig::SetRecord(std::string key, std::string value)
 {
     //Parsing strings
 
+    if(key=="layer")
+        AddLayer(value);
+
     if(key=="simRootFileName")
         simRootFileName = value;
 
@@ -266,11 +322,26 @@ void ProgramConfig::SetRecord(std::string key, std::string value)
     if(key=="rndSeed")
         rndSeed = atoi(value.c_str());
 
+    if(key=="nThreads")
+        nThreads = atoi(value.c_str());
+
     //Parsing integers => to boolean
 
     if(key=="singleCollisionInEvent")
         singleCollisionInEvent = (bool)atoi(value.c_str());
 
+    if(key=="asyncOutput")
+        asyncOutput = (bool)atoi(value.c_str());
+
+    if(key=="pipelineStages")
+        pipelineStages = atoi(value.c_str());
+
+    if(key=="transportBatchSize")
+        transportBatchSize = atoi(value.c_str());
+
+    if(key=="counterBasedRandom")
+        counterBasedRandom = (bool)atoi(value.c_str());
+
     if(key=="singleEventPersistenceEnabled")
         singleEventPersistenceEnabled = (bool)atoi(value.c_str());
 
@@ -280,100 +351,112 @@ void ProgramConfig::SetRecord(std::string key, std::string value)
     if(key=="enableSoftParticlesNoise")
         enableSoftParticlesNoise = (bool)atoi(value.c_str());
 
-    //Parsing names of TObjects to be read from the input .root file
+    if(key=="highlandMultipleScattering")
+        highlandMultipleScattering = (bool)atoi(value.c_str());
+
+    if(key=="acceptancePrefilter")
+        acceptancePrefilter = (bool)atoi(value.c_str());
+
+    if(key=="acceptanceMargin")
+        acceptanceMargin = atof(value.c_str());
 
-    if(key=="collisionPerEventDistribution")
+    if(key=="acceptanceTruthCount")
+        acceptanceTruthCount = (bool)atoi(value.c_str());
+
+    //Parsing the input distributions: parametric definitions or names of TObjects to be read from the input .root file
+
+    if(key=="collisionPerEventDistribution" && !SetParametric(value, samplers.collisionPerEvent))
     {
         delete collisionPerEventDistribution;
         collisionPerEventDistribution = ReadTH1D(value);
     }
         
 
-    if(key=="momentumDistribution")
+    if(key=="momentumDistribution" && !SetParametric(value, samplers.momentum))
     {
         if(momentumDistribution != nullptr) delete momentumDistribution;
         momentumDistribution = ReadTH1D(value);
     }
   
 
-    if(key=="etaDistribution")
+    if(key=="etaDistribution" && !SetParametric(value, samplers.eta))
     {
         if(etaDistribution != nullptr) delete etaDistribution;
         etaDistribution = ReadTH1D(value);
     }
         
 
-    if(key=="multiplicityDistribution")
+    if(key=="multiplicityDistribution" && !SetParametric(value, samplers.multiplicity))
     {
         //if(multiplicityDistribution != nullptr) delete multiplicityDistribution;
         multiplicityDistribution = ReadTH1D(value);
     }
         
 
-    if(key=="phiDistribution")
+    if(key=="phiDistribution" && !SetParametric(value, samplers.phi))
     {
         if(phiDistribution != nullptr) delete phiDistribution;
         phiDistribution = ReadTH1D(value);
     }
         
 
-    if(key=="bunchCrossingX")
+    if(key=="bunchCrossingX" && !SetParametric(value, samplers.bunchCrossingX))
     {
         if(bunchCrossingX != nullptr) delete bunchCrossingX;
         bunchCrossingX = ReadTH1D(value);
     }
         
 
-    if(key=="bunchCrossingY")
+    if(key=="bunchCrossingY" && !SetParametric(value, samplers.bunchCrossingY))
     {
         if(bunchCrossingY != nullptr) delete bunchCrossingY;
         bunchCrossingY = ReadTH1D(value);
     }
         
 
-    if(key=="zPosDistribution")
+    if(key=="zPosDistribution" && !SetParametric(value, samplers.zPos))
     {
         if(zPosDistribution != nullptr) delete zPosDistribution;
         zPosDistribution = ReadTH1D(value);
     }
         
 
-    if(key=="innerSiliconNoise")
+    if(key=="innerSiliconNoise" && !SetParametric(value, samplers.innerSiliconNoise))
     {
         if(innerSiliconNoise != nullptr) delete innerSiliconNoise;
         innerSiliconNoise = ReadTH2D(value);
     }
         
 
-    if(key=="outerSiliconNoise")
+    if(key=="outerSiliconNoise" && !SetParametric(value, samplers.outerSiliconNoise))
     {
         if(outerSiliconNoise != nullptr) delete outerSiliconNoise;
         outerSiliconNoise = ReadTH2D(value);
     }
         
 
-    if(key=="innerCountsDistribution")
+    if(key=="innerCountsDistribution" && !SetParametric(value, samplers.innerCounts))
     {
         if(innerCountsDistribution != nullptr) delete innerCountsDistribution;
         innerCountsDistribution = ReadTH1D(value);
     }
         
 
-    if(key=="outerCountsDistribution")
+    if(key=="outerCountsDistribution" && !SetParametric(value, samplers.outerCounts))
     {
         if(outerCountsDistribution != nullptr) delete outerCountsDistribution;
         outerCountsDistribution = ReadTH1D(value);
     }
         
 
-    if(key=="pixelActivationMap")
+    if(key=="pixelActivationMap" && !SetParametric(value, samplers.pixelActivationMap))
     {
         if(pixelActivationMap != nullptr) delete pixelActivationMap;
         pixelActivationMap = ReadTH2D(value);
     }
         
 
-    if(key=="pixelActivationCount")
+    if(key=="pixelActivationCount" && !SetParametric(value, samplers.pixelActivationCount))
     {
         if(pixelActivationCount != nullptr) delete pixelActivationCount;
         pixelActivationCount = ReadTH1D(value);
@@ -442,6 +525,118 @@ void ProgramConfig::SetRecord(std::string key, std::string value)
     
 }
 
+void ProgramConfig::SetShard(unsigned int index, unsigned int total)
+{
+    if (total == 0 || index >= total)
+    {
+        std::cerr << "\nError: invalid shard " << index << "/" << total << ", the whole run will be simulated.";
+        nShards = 1;
+        shardIndex = 0;
+        return;
+    }
+    nShards = total;
+    shardIndex = index;
+}
+
+unsigned long int ProgramConfig::GetShardFirstEvent()
+{
+    //The first (eventNumber % nShards) shards get one event more than the others
+    unsigned long int base = eventNumber / nShards;
+    unsigned long int extra = eventNumber % nShards;
+    return shardIndex * base + (shardIndex < extra ? shardIndex : extra);
+}
+
+unsigned long int ProgramConfig::GetShardEventNumber()
+{
+    unsigned long int base = eventNumber / nShards;
+    unsigned long int extra = eventNumber % nShards;
+    return base + (shardIndex < extra ? 1 : 0);
+}
+
+int ProgramConfig::GetShardSeed()
+{
+    //The counter-based generator is already keyed on the event ID, so all the shards share the seed and the merged run does not depend on the number of shards
+    if (counterBasedRandom) return rndSeed;
+    return rndSeed + 65536 * shardIndex;
+}
+
+std::string ProgramConfig::GetShardFileName(unsigned int index)
+{
+    if (nShards <= 1) return simRootFileName;
+
+    std::string name = simRootFileName;
+    std::string suffix = "_shard" + std::to_string(index);
+    std::size_t dot = name.rfind(".root");
+    if (dot == std::string::npos) return name + suffix;
+    return name.insert(dot, suffix);
+}
+
+void ProgramConfig::PrepareSampling()
+{
+    AliasSampler::Build(collisionPerEventDistribution, samplers.collisionPerEvent.histogram);
+    AliasSampler::Build(momentumDistribution, samplers.momentum.histogram);
+    AliasSampler::Build(etaDistribution, samplers.eta.histogram);
+    AliasSampler::Build(multiplicityDistribution, samplers.multiplicity.histogram);
+    AliasSampler::Build(phiDistribution, samplers.phi.histogram);
+    AliasSampler::Build(bunchCrossingX, samplers.bunchCrossingX.histogram);
+    AliasSampler::Build(bunchCrossingY, samplers.bunchCrossingY.histogram);
+    AliasSampler::Build(zPosDistribution, samplers.zPos.histogram);
+    AliasSampler::Build(innerCountsDistribution, samplers.innerCounts.histogram);
+    AliasSampler::Build(outerCountsDistribution, samplers.outerCounts.histogram);
+    AliasSampler::Build(pixelActivationCount, samplers.pixelActivationCount.histogram);
+
+    AliasSampler::Build2D(innerSiliconNoise, samplers.innerSiliconNoise.histogram);
+    AliasSampler::Build2D(outerSiliconNoise, samplers.outerSiliconNoise.histogram);
+    AliasSampler::Build2D(pixelActivationMap, samplers.pixelActivationMap.histogram);
+}
+
+bool ProgramConfig::SetParametric(std::string value, Distribution1D &distribution)
+{
+    //Values without parentheses are names of histograms in the input file
+    if (value.find('(') == std::string::npos)
+    {
+        distribution.shape = InputDistribution::kHistogram;
+        return false;
+    }
+
+    int shape;
+    Double_t par[2];
+    if (!InputDistribution::Parse(value, 1, shape, par))
+    {
+        //The value is then looked up as the name of a histogram of the input file
+        distribution.shape = InputDistribution::kHistogram;
+        std::cerr << "\nError: " << value << " is not a valid 1D distribution (uniform(a,b), gaus(mu,sigma), poisson(mean), fixed(x)). Read as the name of a histogram.";
+        return false;
+    }
+
+    distribution.shape = shape;
+    for (unsigned int i = 0; i < 2; ++i) distribution.par[i] = par[i];
+    return true;
+}
+
+bool ProgramConfig::SetParametric(std::string value, Distribution2D &distribution)
+{
+    if (value.find('(') == std::string::npos)
+    {
+        distribution.shape = InputDistribution::kHistogram;
+        return false;
+    }
+
+    int shape;
+    Double_t par[4];
+    if (!InputDistribution::Parse(value, 2, shape, par))
+    {
+        //The value is then looked up as the name of a histogram of the input file
+        distribution.shape = InputDistribution::kHistogram;
+        std::cerr << "\nError: " << value << " is not a valid 2D distribution (uniform(xMin,xMax,yMin,yMax), gaus(muX,sigmaX,muY,sigmaY), fixed(x,y)). Read as the name of a histogram.";
+        return false;
+    }
+
+    distribution.shape = shape;
+    for (unsigned int i = 0; i < 4; ++i) distribution.par[i] = par[i];
+    return true;
+}
+
 //Possible upgrade: replace multiple functions with ::ReadObject() with templates!
 TH1D * ProgramConfig::ReadTH1D(std::string key)
 {
@@ -43,38 +43,42 @@ void DetectorEffects::SoftParticlePixelNoise(EventManager * event)
     RunManager * currentRun = event->GetRun();
     Double_t nInner, nOuter;
 
-    nInner = conf->innerCountsDistribution->GetRandom(rndEngine);
-    nOuter = conf->outerCountsDistribution->GetRandom(rndEngine);
+    nInner = InputDistribution::Sample(conf->samplers.innerCounts, rndEngine);
+    nOuter = InputDistribution::Sample(conf->samplers.outerCounts, rndEngine);
 
-    Double_t rInner = conf->innerSiliconRadius;
-    Double_t rOuter = conf->outerSiliconRadius;
+    //The noise is generated on the layers with detectorID 1 and 2, the ones used by the reconstruction
+    const std::vector<LayerConfig> &layers = conf->GetLayers();
+    Double_t rInner = (layers.size() > 2) ? layers[1].radius : conf->innerSiliconRadius;
+    Double_t rOuter = (layers.size() > 2) ? layers[2].radius : conf->outerSiliconRadius;
 
     for (unsigned int i = 0; i < nInner; ++i)
     {
-        conf->innerSiliconNoise->GetRandom2(phi_inner, z_inner, rndEngine);
-
-        //Fill the TTree!
-        dhit.X = rInner * TMath::Cos(phi_inner);
-        dhit.Y = rInner * TMath::Sin(phi_inner);
-        dhit.Z = z_inner;
-        dhit.eventID = event->GetEventID();
-        dhit.particleID = 0;
-        dhit.detectorID = 1;
-        event->GetRun()->GetBranch("DetectorHits")->Fill();
+        InputDistribution::Sample2D(conf->samplers.innerSiliconNoise, phi_inner, z_inner, rndEngine);
+
+        //Add the noise hit to the event record
+        DetHit detHit;
+        detHit.X = rInner * TMath::Cos(phi_inner);
+        detHit.Y = rInner * TMath::Sin(phi_inner);
+        detHit.Z = z_inner;
+        detHit.eventID = event->GetEventID();
+        detHit.particleID = 0;
+        detHit.detectorID = 1;
+        event->record.detHits.push_back(detHit);
     }
 
     for (unsigned int i = 0; i < nOuter; ++i)
     {
-        conf->outerSiliconNoise->GetRandom2(phi_outer, z_outer, rndEngine);
-
-        //Fill the TTree!
-        dhit.X = rOuter * TMath::Cos(phi_outer);
-        dhit.Y = rOuter * TMath::Sin(phi_outer);
-        dhit.Z = z_outer;
-        dhit.eventID = event->GetEventID();
-        dhit.particleID = 0;
-        dhit.detectorID = 2;
-        event->GetRun()->GetBranch("DetectorHits")->Fill();
+        InputDistribution::Sample2D(conf->samplers.outerSiliconNoise, phi_outer, z_outer, rndEngine);
+
+        //Add the noise hit to the event record
+        DetHit detHit;
+        detHit.X = rOuter * TMath::Cos(phi_outer);
+        detHit.Y = rOuter * TMath::Sin(phi_outer);
+        detHit.Z = z_outer;
+        detHit.eventID = event->GetEventID();
+        detHit.particleID = 0;
+        detHit.detectorID = 2;
+        event->record.detHits.push_back(detHit);
     }
     
 }
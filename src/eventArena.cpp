@@ -0,0 +1,77 @@
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include<iostream>
+#include "../inc/eventArena.h"
+
+//Definition of static data members
+std::mutex EventArena::cacheMutex;
+std::vector<char *> EventArena::chunkCache;
+
+EventArena::~EventArena()
+{
+    DestroyObjects();
+    for (unsigned long int i = 0; i < chunks.size(); ++i)
+        ReleaseChunk(chunks[i]);
+}
+
+void EventArena::DestroyObjects()
+{
+    for (unsigned long int i = destructors.size(); i > 0; --i)
+        destructors[i - 1].destroy(destructors[i - 1].object);
+    destructors.clear();
+}
+
+void EventArena::Reset()
+{
+    DestroyObjects();
+    if (chunks.size() == 0) return;
+
+    for (unsigned long int i = 1; i < chunks.size(); ++i)
+        ReleaseChunk(chunks[i]);
+    chunks.resize(1);
+    offset = 0;
+}
+
+void EventArena::NewChunk(std::size_t size)
+{
+    if (size > kChunkSize)
+    {
+        std::cerr << "\nCritical error: object of " << size << " bytes does not fit in an arena chunk.";
+        throw std::bad_alloc();
+    }
+    chunks.push_back(AcquireChunk());
+    offset = 0;
+}
+
+char * EventArena::AcquireChunk()
+{
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (chunkCache.size() > 0)
+        {
+            char * chunk = chunkCache.back();
+            chunkCache.pop_back();
+            return chunk;
+        }
+    }
+    return static_cast<char *>(::operator new(kChunkSize));
+}
+
+void EventArena::ReleaseChunk(char * chunk)
+{
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (chunkCache.size() < kMaxCachedChunks)
+        {
+            chunkCache.push_back(chunk);
+            return;
+        }
+    }
+    ::operator delete(chunk);
+}
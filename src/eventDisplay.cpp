@@ -124,7 +124,7 @@ void EventDisplay::DrawEvent()
             deltaZ = deltaZ - origZ;
 
             TEveArrow * a1 = new TEveArrow(deltaX, deltaY, deltaZ, origX, origY, origZ);
-            std::string trackname = "Part.ID=" + std::to_string(currentEvent->tracks[i]->GetParticleID()) + " P=" + std::to_string(currentEvent->tracks[i]->GetMomentum() * c / GeV) + " GeV/c";
+            std::string trackname = "Part.ID=" + std::to_string(currentEvent->tracks[i]->GetParticleID()) + " P=" + std::to_string(currentEvent->tracks[i]->GetMomentum() * Units::c / Units::GeV) + " GeV/c";
             a1->SetNameTitle(trackname.c_str(), trackname.c_str());
             a1->SetMainColor(kGreen);
             a1->SetTubeR(lineWidth);
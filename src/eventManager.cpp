@@ -13,19 +13,28 @@ ClassImp(EventManager)
 EventManager::EventManager()
 {
     eventID = GenerateEventID();
-    tracks.reserve(100);
-    hits.reserve(100);
+    trackStates.reserve(100);
+}
+
+EventManager::EventManager(Int_t eventIdentifier)
+{
+    eventID = eventIdentifier;
+    trackStates.reserve(100);
 }
 
 EventManager::EventManager(const EventManager &eventSource) : TObject()
 {
+    //The copy owns its tracks and hits, stored in its own arena
     for (unsigned long int i = 0; i < eventSource.tracks.size(); ++i)
-        tracks.push_back(eventSource.tracks[i]);
+        tracks.push_back(arena.New<Track>(*eventSource.tracks[i]));
     
     for (unsigned long int i = 0; i < eventSource.hits.size(); ++i)
-        hits.push_back(eventSource.hits[i]);
+        hits.push_back(arena.New<Hit>(*eventSource.hits[i]));
+
+    trackStates = eventSource.trackStates;
 
     runManager = eventSource.runManager;
+    record = eventSource.record;
     eventID = eventSource.eventID;
     persist = eventSource.persist;
     tracks.reserve(100);
@@ -40,6 +49,26 @@ EventManager::~EventManager()
 void EventManager::SetPersist(bool eventPersist)
 {
     persist = eventPersist;
+    if (!persist) return;
+
+    //Only persistent events build Track and Hit objects
+    tracks.reserve(100);
+    hits.reserve(100);
+}
+
+Track * EventManager::NewTrack()
+{
+    return arena.New<Track>();
+}
+
+Track * EventManager::NewTrack(unsigned long int particleID)
+{
+    return arena.New<Track>(particleID);
+}
+
+Hit * EventManager::NewHit()
+{
+    return arena.New<Hit>();
 }
 
 Int_t EventManager::GetEventID()
@@ -54,8 +83,7 @@ RunManager * EventManager::GetRun()
 
 long int EventManager::GenerateEventID()
 {
-    eventIDCounter++;
-    return eventIDCounter;
+    return ++eventIDCounter;
 }
 
 bool EventManager::IsPersist()
@@ -66,12 +94,9 @@ bool EventManager::IsPersist()
 void EventManager::CleanupEvent()
 {
     // [MEM LEAK CHECK] std::cerr << "\nDelete event invocated!";
-    for (unsigned int i = 0; i < tracks.size(); ++i)
-        delete tracks[i];
-
-    for (unsigned int i = 0; i < hits.size(); ++i)
-        delete hits[i];
-
+    //The tracks and hits are destroyed and released all together with the event arena
     tracks.clear();
     hits.clear();
-}
\ No newline at end of file
+    trackStates.clear();
+    arena.Reset();
+}
@@ -14,6 +14,7 @@
 
 ExperimentSimulation::ExperimentSimulation()
 {
+    worldVolume = nullptr;
     //gSystem->Load("libGeom");
     //R__LOAD_LIBRARY("libGeom");
     //worldVolume = new TGeoManager();
@@ -22,9 +23,8 @@ ExperimentSimulation::ExperimentSimulation()
 
 ExperimentSimulation::~ExperimentSimulation()
 {
-    delete outerSiPlane;
-    delete innerSiPlane;
-    delete beamPipe;
+    for (unsigned int j = 0; j < geometryRegister.size(); ++j)
+        delete geometryRegister[j];
     delete vacuum;
     delete berillium;
     delete silicon;
@@ -33,19 +33,52 @@ ExperimentSimulation::~ExperimentSimulation()
 
 void ExperimentSimulation::BuildGeometry()
 {
+    //A, Z, density (g/cm3), radiation and nuclear interaction lengths (negative: given, not computed by TGeo)
     vacuum      = new TGeoMaterial("Vacuum",0,0,0);
-    berillium   = new TGeoMaterial("Berillium",0,0,0);
-    silicon     = new TGeoMaterial("Silicon",0,0,0);
+    berillium   = new TGeoMaterial("Berillium", 9.012182, 4, 1.848, -35.28 * Units::cm, -42.10 * Units::cm);
+    silicon     = new TGeoMaterial("Silicon", 28.0855, 14, 2.329, -9.370 * Units::cm, -46.52 * Units::cm);
 
-    beamPipe     = new TGeoTube(conf->beamPipeRadius - conf->beamPipeTickness / 2., conf->beamPipeRadius + conf->beamPipeTickness / 2., conf->beamPipeLenght / 2.);
-    innerSiPlane = new TGeoTube(conf->innerSiliconRadius - conf->siliconTickness / 2., conf->innerSiliconRadius + conf->siliconTickness / 2., conf->innerSiLenght / 2.);
-    outerSiPlane = new TGeoTube(conf->outerSiliconRadius - conf->siliconTickness / 2., conf->outerSiliconRadius + conf->siliconTickness / 2., conf->outerSiLenght / 2.);
+    //One tube per layer of the configuration, the index in the register is the detectorID of the layer
+    const std::vector<LayerConfig> &layers = conf->GetLayers();
+    for (unsigned int j = 0; j < layers.size(); ++j)
+    {
+        geometryRegister.push_back(new TGeoTube(layers[j].radius - layers[j].thickness / 2., layers[j].radius + layers[j].thickness / 2., layers[j].length / 2.));
+        materialRegister.push_back(GetMaterial(layers[j].material));
+    }
 
-    
-    geometryRegister.push_back(beamPipe);       //index = 0;
-    geometryRegister.push_back(innerSiPlane);   //index = 1;
-    geometryRegister.push_back(outerSiPlane);   //index = 2;
+    //Compile the geometry in the radius ordered layer table used by the transport
+    for (unsigned int j = 0; j < geometryRegister.size(); ++j)
+    {
+        Double_t R = (geometryRegister[j]->GetRmax() + geometryRegister[j]->GetRmin()) / 2; //Mean radius
+        Double_t thickness = geometryRegister[j]->GetRmax() - geometryRegister[j]->GetRmin();
+        IntersectionKernel::AddLayer(layerTable, R, geometryRegister[j]->GetDz(), thickness, materialRegister[j]->GetRadLen(), materialRegister[j]->GetZ(), j, layers[j].sensitive);
+    }
+
+    //Multiple scattering constant of each layer, computed once: at every crossing the Highland formula is a multiplication and a division
+    for (unsigned int j = 0; j < layerTable.nLayers; ++j)
+    {
+        Double_t radLength = (materialRegister[layerTable.detectorID[j]] == vacuum) ? 0. : layerTable.radLength[j];
+        highlandConstant.push_back(TransportEngine::HighlandConstant(TMath::Nint(conf->charge / Units::e), layerTable.thickness[j], radLength));
+    }
 
+    //Segmentation of the layers in pixel modules, resolved after the intersection with the cylinder
+    int nModules = 0;
+    for (unsigned int j = 0; j < layers.size(); ++j)
+    {
+        moduleGrid.push_back(ModuleGrid::BuildLayout(layers[j].radius, layers[j].length / 2., layers[j].nPhiModules, layers[j].nZModules, layers[j].moduleWidth, layers[j].moduleLength, nModules));
+        nModules += ModuleGrid::Modules(moduleGrid[j]);
+    }
+
+}
+
+TGeoMaterial * ExperimentSimulation::GetMaterial(std::string name)
+{
+    if (name == "Vacuum") return vacuum;
+    if (name == "Berillium") return berillium;
+    if (name == "Silicon") return silicon;
+
+    std::cerr << "\nError: unknown material " << name << ", the layer will be made of vacuum.";
+    return vacuum;
 }
 
 void ExperimentSimulation::ProcessEvent(EventManager * currentEvent)
@@ -57,7 +90,18 @@ void ExperimentSimulation::ProcessEvent(EventManager * currentEvent)
         return;
     } 
 
-    bool iterate = true;
+    if (eventTransport == nullptr) SelectTransport();
+
+    //The transport stream of the event has been selected by the RunManager
+    eventRandom.Reset(rndEngine);
+    random = &eventRandom;
+
+    //Without persistence the segment history is not needed: each particle is a TrackState, stepped and scattered in place
+    if (!currentEvent->IsPersist())
+    {
+        (this->*eventTransport)(currentEvent);
+        return;
+    }
 
     unsigned long int iterator = 0;
     while(iterator < currentEvent->tracks.size())
@@ -70,12 +114,118 @@ void ExperimentSimulation::ProcessEvent(EventManager * currentEvent)
     }
 }
 
+void ExperimentSimulation::SelectTransport()
+{
+    unsigned int flags = 0;
+    if (physicsList.multipleScattering) flags |= PhysicsPolicy::kMultipleScattering;
+    if (!physicsList.multipleScatteringThetaMsApprox) flags |= PhysicsPolicy::kHighland;
+    if (!conf->disableKin) flags |= PhysicsPolicy::kKinematics;
+    if (conf->enableHitGaussianSmearing) flags |= PhysicsPolicy::kSmearing;
+
+    SelectTransportFlags<PhysicsPolicy::kAll>(flags);
+}
+
+template<unsigned int kFlags>
+void ExperimentSimulation::SelectTransportFlags(unsigned int flags)
+{
+    if (flags == kFlags)
+    {
+        eventTransport = &ExperimentSimulation::TransportStates<kFlags>;
+        batchTransport = &ExperimentSimulation::TransportBatch<kFlags>;
+        recordHit = &ExperimentSimulation::RecordHit<kFlags>;
+        return;
+    }
+
+    //Instantiates the transport for all the combinations of the options, from kAll down to 0
+    if (kFlags > 0) SelectTransportFlags<(kFlags > 0) ? kFlags - 1 : 0>(flags);
+}
+
+template<unsigned int kFlags>
+void ExperimentSimulation::TransportStates(EventManager * currentEvent)
+{
+    //One layer per pass over the particles: the steps (and the random draws) follow the same order as appending the scattered tracks
+    bool iterate = true;
+    while(iterate)
+    {
+        iterate = false;
+        for (unsigned long int iterator = 0; iterator < currentEvent->trackStates.size(); ++iterator)
+        {
+            TrackState &state = currentEvent->trackStates[iterator];
+            if (!state.active) continue;
+
+            ProcessTrackState<kFlags>(currentEvent, state);
+            if (state.active) iterate = true;
+        }
+    }
+}
+
+template<unsigned int kFlags>
+void ExperimentSimulation::ProcessTrackState(EventManager * currentEvent, TrackState &state)
+{
+    //Get the first intersection between the track and geometry (time ordered), starting from the layer after the last crossed one
+    Double_t tMin;
+    int layer = IntersectionKernel::IntersectNext(state.x0, state.y0, state.z0, state.dx * state.speed, state.dy * state.speed, state.dz * state.speed, layerTable, state.nextLayer, tMin);
+
+    //This particle does not interact with any part of the detector, stop tracking
+    if (layer < 0)
+    {
+        state.active = false;
+        return;
+    }
+
+    TransportReal v = state.speed * tMin;
+    TransportReal xHit = state.x0 + v * state.dx;
+    TransportReal yHit = state.y0 + v * state.dy;
+    TransportReal zHit = state.z0 + v * state.dz;
+
+    //Gap between the modules: the particle continues unchanged to the next layer
+    if (!InModule(layer, xHit, yHit, zHit))
+    {
+        state.nextLayer = layer + 1;
+        state.x0 = xHit;
+        state.y0 = yHit;
+        state.z0 = zHit;
+        return;
+    }
+
+    //Add the hit to the event record (the hits on the passive layers are not recorded)
+    RecordHit<kFlags>(currentEvent, state.particleID, xHit, yHit, zHit, layer);
+
+    //Outermost layer or multiple scattering disabled: stop tracking
+    if (!ScatterAtLayer<kFlags>(layer, state.p, state.beta, state.dx, state.dy, state.dz))
+    {
+        state.active = false;
+        return;
+    }
+
+    state.nextLayer = layer + 1;
+    state.x0 = xHit;
+    state.y0 = yHit;
+    state.z0 = zHit;
+}
+
+template<unsigned int kFlags>
+bool ExperimentSimulation::ScatterAtLayer(int layer, Double_t p, Double_t beta, TransportReal &dx, TransportReal &dy, TransportReal &dz)
+{
+    if (!(kFlags & PhysicsPolicy::kMultipleScattering) || ((unsigned int)layer + 1 == layerTable.nLayers)) return false;
+
+    //Same options passed to MultipleScattering by ProcessTrack: the kinematics is always enabled in the sensitive layers
+    Double_t theta0 = .001; // 1 mrad
+    if ((kFlags & PhysicsPolicy::kHighland) && ((kFlags & PhysicsPolicy::kKinematics) || layerTable.sensitive[layer]))
+        theta0 = TransportEngine::HighlandTheta0(beta, p, highlandConstant[layer]);
+
+    //The rotation is computed in double precision also in the single precision transport
+    Double_t ux = dx, uy = dy, uz = dz;
+    TransportEngine::ScatterDirection(ux, uy, uz, theta0, random);
+    dx = ux;
+    dy = uy;
+    dz = uz;
+    return true;
+}
+
 int ExperimentSimulation::GetGeomIntersection(Track * currentTrack, Hit * hit)
 {
-    int interactionGeomIndex = -1;
     Double_t tMin = 1; //1s
-    bool empty = true;
-    Double_t rMin = 0;
     
     Double_t x0 = currentTrack->GetTrackStartX();
     Double_t y0 = currentTrack->GetTrackStartY();
@@ -90,129 +240,82 @@ int ExperimentSimulation::GetGeomIntersection(Track * currentTrack, Hit * hit)
     v2 = currentTrack->GetVelocityY();
     v3 = currentTrack->GetVelocityZ();
 
-    for (unsigned int j = 0; j < (uint)geometryRegister.size(); ++j)
-    {
-        Double_t t = 0;
-        Double_t R = (geometryRegister[j]->GetRmax() + geometryRegister[j]->GetRmin()) / 2; //Mean radius
-        Double_t H = geometryRegister[j]->GetDz(); //Half lenght
-
-       Double_t Delta = (x0*v1 + y0*v2) * (x0*v1 + y0*v2);
-       Delta -= (v1*v1 + v2*v2) * (x0*x0 + y0*y0 - R*R);
-       
-       t  = (-1. * (x0*v1 + y0*v2) + TMath::Sqrt(Delta)) / (v1*v1 + v2*v2);
-       Double_t zz = z0 + v3*t;
-       
-       if((zz < H) && (zz > (-1. * H)) && (t > 1e-15)) //check Z of the intersection point
-       { 
-            if((t < tMin)) 
-            {
-                interactionGeomIndex = j;
-                tMin = t;
-                empty = false;
-                rMin = R;
-            }
-       }
-       else
-       {
+    //Quadratic equation for the layers outside the start point, the first valid intersection (inside the layer length) is selected
+    unsigned int first = IntersectionKernel::FirstLayerOutside(layerTable, x0, y0);
+    int layer = IntersectionKernel::IntersectNext(x0, y0, z0, v1, v2, v3, layerTable, first, tMin);
 
-       }
+    //The crossings of the gaps between the modules do not change the track, continue to the next layer
+    Double_t t0 = 0.;
+    while ((layer >= 0) && !InModule(layer, x0 + tMin * v1, y0 + tMin * v2, z0 + tMin * v3))
+    {
+        x0 += tMin * v1;
+        y0 += tMin * v2;
+        z0 += tMin * v3;
+        t0 += tMin;
+        layer = IntersectionKernel::IntersectNext(x0, y0, z0, v1, v2, v3, layerTable, layer + 1, tMin);
     }
 
-    if(!empty)
+    if(layer >= 0)
     {
         hit->SetX(x0 + tMin * v1);
         hit->SetY(y0 + tMin * v2);
         hit->SetZ(z0 + tMin * v3);
-        hit->SetT(tMin);
+        hit->SetT(t0 + tMin);
         //std::cerr << "\nTmin =" <<  tMin;
     }
 
-    return interactionGeomIndex;
+    return layer;
 }
 
 void ExperimentSimulation::ProcessTrack(Track * currentTrack)
 {
-    bool reuseMem = false;
-    Hit * hit = new Hit();
     EventManager * currentEvent = currentTrack->GetEvent();
+    Hit * hit = currentEvent->NewHit();
 
     //Get the first intersection between the track and geometry (time ordered)
-    int interactionGeomIndex = GetGeomIntersection(currentTrack, hit);
+    int layer = GetGeomIntersection(currentTrack, hit);
 
-    //Beam pipe
-    if(interactionGeomIndex  == 0)
+    //This particle does not interact with any part of the detector, stop tracking
+    if (layer < 0)
     {
-        
-        //Add the hit to the event hit storage and to the run TTree
-        ProcessHit(currentTrack, hit, interactionGeomIndex);
-
-        //Check if the multiple scattering physics process simulation is enabled
-        if (physicsList.multipleScattering == true)
-        {
-            Track * tr1 = new Track();
-            Double_t zMat = 0., x = 0., xr = 0.;
-            TransportEngine::MultipleScattering(currentTrack, tr1, hit, zMat, x, xr, physicsList.multipleScatteringThetaMsApprox, !conf->disableKin);
-            //std::cerr << "\nCalled multiple scattering tracks: " << currentTrack << "  ParticleID=" << currentTrack->GetParticleID() << "  -> " << tr1 << "  ParticleID=" << tr1->GetParticleID();
-            currentEvent->tracks.push_back(tr1);
-        }
-        
+        currentTrack->SetNoStop(true);
+        currentTrack->SetActiveTrack(false);
         return;
     }
 
-    //Inner silicon plane
-    if(interactionGeomIndex == 1)
-    {
-
-
-        //Add the hit to the event hit storage and to the run TTree
-        ProcessHit(currentTrack, hit, interactionGeomIndex);
-
-        //Check if the multiple scattering physics process simulation is enabled
-        if (physicsList.multipleScattering == true)
-        {
-            Track * tr2 = new Track();
-            Double_t zMat = 0., x = 0., xr = 0.;
-            TransportEngine::MultipleScattering(currentTrack, tr2, hit, zMat, x, xr, physicsList.multipleScatteringThetaMsApprox);
-            //std::cerr << "\nCalled multiple scattering tracks: " << currentTrack << "  ParticleID=" << currentTrack->GetParticleID() << "  -> " << tr2 << "  ParticleID=" << tr2->GetParticleID();
-            currentEvent->tracks.push_back(tr2);
-            
-        }
-
-        return;
-    }
+    //Add the hit to the event hit storage and to the run TTree
+    ProcessHit(currentTrack, hit, layer);
 
-    //Outer silicon plane
-    if(interactionGeomIndex == 2)
+    //Outermost layer or multiple scattering disabled: stop tracking
+    if (((unsigned int)layer + 1 == layerTable.nLayers) || (physicsList.multipleScattering == false))
     {
-        //Add the hit to the run TTree
-        ProcessHit(currentTrack, hit, interactionGeomIndex);
         currentTrack->SetTrackStop(hit->X(), hit->Y(), hit->Z());
         currentTrack->SetActiveTrack(false);
         return;
     }
-    
-    //This particle does not interact with any part of the detector, stop tracking
-    currentTrack->SetNoStop(true);
-    if (!reuseMem) currentTrack->SetActiveTrack(false);
-    
+
+    //The scattering in the passive layers (beam pipe) follows the kinematics option, in the sensitive layers it is always enabled
+    bool kinematics = layerTable.sensitive[layer] ? true : !conf->disableKin;
+
+    Track * tr = currentEvent->NewTrack();
+    TransportEngine::MultipleScattering(currentTrack, tr, hit, highlandConstant[layer], physicsList.multipleScatteringThetaMsApprox, kinematics, random);
+    //std::cerr << "\nCalled multiple scattering tracks: " << currentTrack << "  ParticleID=" << currentTrack->GetParticleID() << "  -> " << tr << "  ParticleID=" << tr->GetParticleID();
+    currentEvent->tracks.push_back(tr);
 }
 
 
-void ExperimentSimulation::ProcessHit(Track * &currentTrack, Hit * hit, int detectorId)
+void ExperimentSimulation::ProcessHit(Track * &currentTrack, Hit * hit, int layer)
 {
-    RunManager * currentRun = currentTrack->GetEvent()->GetRun();
-    Double_t xHit, yHit, zHit;
-    xHit = hit->X();
-    yHit = hit->Y();
-    zHit = hit->Z();
+    (this->*recordHit)(currentTrack->GetEvent(), currentTrack->GetParticleID(), hit->X(), hit->Y(), hit->Z(), layer);
 
-    unsigned long int particleID = currentTrack->GetParticleID();
+    //Only persistent events build Hit objects, the hit is kept with the MC truth of the event
+    currentTrack->GetEvent()->hits.push_back(hit);
+}
 
-    Double_t norm = TMath::Sqrt(xHit * xHit + yHit * yHit + zHit * zHit);
+template<unsigned int kFlags>
+void ExperimentSimulation::RecordHit(EventManager * currentEvent, ULong64_t particleID, Double_t xHit, Double_t yHit, Double_t zHit, int layer)
+{
     Double_t normPlane = TMath::Sqrt(xHit * xHit + yHit * yHit);
-    Double_t thetaHit = TMath::ACos(zHit / norm);
-    Double_t phiHit   = TMath::ACos((xHit / norm) / TMath::Sin(thetaHit));
-    if(yHit < 0) phiHit = 2*TMath::Pi() - phiHit;
 
     // Int_t noPixels = conf->pixelActivationCount->GetRandom(rndEngine);
     // for (unsigned int i = 0; i < noPixels; ++i)
@@ -220,42 +323,136 @@ void ExperimentSimulation::ProcessHit(Track * &currentTrack, Hit * hit, int dete
 
     Double_t deltaZHit = 0.;
     Double_t deltaAr = 0.;
-    if (conf->enableHitGaussianSmearing) conf->pixelActivationMap->GetRandom2(deltaZHit, deltaAr, rndEngine);
+    if (kFlags & PhysicsPolicy::kSmearing) InputDistribution::Sample2D(conf->samplers.pixelActivationMap, deltaZHit, deltaAr, random);
 
-    Double_t recX = normPlane * TMath::Cos(phiHit + deltaAr/normPlane);
-    Double_t recY = normPlane * TMath::Sin(phiHit + deltaAr/normPlane);
+    //The r-phi smearing is a rotation of the hit by deltaAr/normPlane around the beam axis
+    Double_t sinDelta, cosDelta;
+    FastMath::SinCos(deltaAr / normPlane, sinDelta, cosDelta);
+    Double_t recX = xHit * cosDelta - yHit * sinDelta;
+    Double_t recY = xHit * sinDelta + yHit * cosDelta;
     Double_t recZ = zHit + deltaZHit;
 
-    //std::cerr << "\nRecorded hit from track " << currentTrack << "  ParticleID=" << currentTrack->GetParticleID() << "  detectorID = " << detectorId;
+    //std::cerr << "\nRecorded hit from track ParticleID=" << particleID << "  layer = " << layer;
 
-    //Do not record in the TTree hits with the beam pipe
-    if (detectorId != 0)
+    //Do not record in the TTree hits with the passive layers (beam pipe)
+    if (layerTable.sensitive[layer])
     {
-        //Fill the TTree!
-        tree->GetBranch("DetectorHits")->SetAddress(&dhit.X);
-        dhit.X = recX;
-        dhit.Y = recY;
-        dhit.Z = recZ;
-        dhit.eventID = currentTrack->GetEvent()->GetEventID();
-        dhit.particleID = currentTrack->GetParticleID();
-        dhit.detectorID = detectorId;
-        tree->GetBranch("DetectorHits")->Fill();
-        //std::cerr << "\nSILICON TRACKER HIT - detectorId=" << detectorId << "  (" << recX << "  " << recY << "  " << recZ << ")  ParticleID=" << particleID << "  eventID = " << dhit.eventID;
+        //Add the hit to the event record, it will be written in the TTree by the RunManager
+        DetHit detHit;
+        detHit.X = recX;
+        detHit.Y = recY;
+        detHit.Z = recZ;
+        detHit.eventID = currentEvent->GetEventID();
+        detHit.particleID = particleID;
+        detHit.detectorID = layerTable.detectorID[layer];
+        currentEvent->record.detHits.push_back(detHit);
+        //std::cerr << "\nSILICON TRACKER HIT - detectorId=" << detectorId << "  (" << recX << "  " << recY << "  " << recZ << ")  ParticleID=" << particleID << "  eventID = " << detHit.eventID;
     }
 
     // }
-    
+}
+
+void ExperimentSimulation::ProcessEventBatch(std::vector<EventManager *> &events)
+{
+    if (geometryRegister.size() == 0)
+    {
+        if (msg == false) std::cout << "\nCritical error: empty geometry register. Aborting simulation.";
+        msg = true;
+        return;
+    }
+
+    if (batchTransport == nullptr) SelectTransport();
+    (this->*batchTransport)(events);
+}
 
-    if(currentTrack->GetEvent()->IsPersist())
+template<unsigned int kFlags>
+void ExperimentSimulation::TransportBatch(std::vector<EventManager *> &events)
+{
+    //Each event has its own buffer, with its own position in the transport stream, so that with the counter-based
+    //generator the random numbers of an event do not depend on the other events of the block
+    if (batchRandom.size() < events.size()) batchRandom.resize(events.size());
+    for (unsigned int e = 0; e < events.size(); ++e)
     {
-        currentTrack->GetEvent()->hits.push_back(hit);
+        rndEngine->SetEventStream(events[e]->GetEventID(), RndEngine::kTransportStream);
+        batchRandom[e].Reset(rndEngine);
     }
-    else
+
+    GatherTracks(events);
+
+    //Every step moves all the active tracks to their next layer. The tracks of an event keep the same
+    //order of ProcessEvent (primaries first, then the scattered tracks), so the draws of each event are the same
+    while (batch.Size() > 0)
     {
-        delete hit;
+        BatchIntersection();
+
+        unsigned long int n = batch.Size();
+        unsigned long int nActive = 0;
+
+        for (unsigned long int i = 0; i < n; ++i)
+        {
+            int j = batch.layer[i];
+
+            //This particle does not interact with any part of the detector, stop tracking
+            if (j < 0) continue;
+
+            unsigned int e = batch.eventIndex[i];
+            random = &batchRandom[e];
+
+            TransportReal v = batch.speed[i] * batch.tHit[i];
+            TransportReal xHit = batch.x0[i] + v * batch.dx[i];
+            TransportReal yHit = batch.y0[i] + v * batch.dy[i];
+            TransportReal zHit = batch.z0[i] + v * batch.dz[i];
+
+            //Gap between the modules: the particle continues unchanged to the next layer
+            if (InModule(j, xHit, yHit, zHit))
+            {
+                //Add the hit to the event record (the hits on the passive layers are not recorded)
+                RecordHit<kFlags>(events[e], batch.particleID[i], xHit, yHit, zHit, j);
+
+                //Outermost layer or multiple scattering disabled: stop tracking
+                if (!ScatterAtLayer<kFlags>(j, batch.p[i], batch.speed[i] / Units::c, batch.dx[i], batch.dy[i], batch.dz[i])) continue;
+            }
+
+            batch.nextLayer[i] = j + 1;
+            batch.x0[i] = xHit;
+            batch.y0[i] = yHit;
+            batch.z0[i] = zHit;
+
+            //Compact the tracks that are still active at the beginning of the arrays
+            if (nActive != i) batch.Move(i, nActive);
+            nActive++;
+        }
+
+        batch.Resize(nActive);
+    }
+}
+
+void ExperimentSimulation::GatherTracks(std::vector<EventManager *> &events)
+{
+    batch.Clear();
+
+    for (unsigned int e = 0; e < events.size(); ++e)
+    {
+        std::vector<TrackState> &states = events[e]->trackStates;
+        for (unsigned long int k = 0; k < states.size(); ++k)
+        {
+            TrackState &s = states[k];
+            if (!s.active) continue;
+
+            batch.Push(s.x0, s.y0, s.z0, s.dx, s.dy, s.dz, s.p, s.speed, e, s.particleID, s.nextLayer);
+
+            //From now on the particle is transported by the batch
+            s.active = false;
+        }
     }
 }
 
+void ExperimentSimulation::BatchIntersection()
+{
+    //Next layer stepping of GetGeomIntersection, several tracks at a time
+    IntersectionKernel::IntersectTracks(batch.Size(), batch.x0.data(), batch.y0.data(), batch.z0.data(), batch.dx.data(), batch.dy.data(), batch.dz.data(), batch.speed.data(), batch.nextLayer.data(), layerTable, batch.tHit.data(), batch.layer.data());
+}
+
 void ExperimentSimulation::SetRndEngine(RndEngine * RndE)
 {
     rndEngine = RndE;
@@ -264,6 +461,7 @@ void ExperimentSimulation::SetRndEngine(RndEngine * RndE)
 void ExperimentSimulation::SetConfiguration(ProgramConfig * config)
 {
     conf = config;
+    physicsList.multipleScatteringThetaMsApprox = !conf->highlandMultipleScattering;
 }
 
 std::vector<TGeoTube *> ExperimentSimulation::GetGeometry()
@@ -116,15 +116,23 @@ void HitsAnalysis::CalculateZrec(TFile * simFile, int nTTreeVersions, double dPh
 void HitsAnalysis::GetIntersections(std::vector<double> vX1,std::vector<double> vX2,std::vector<double> vY1,std::vector<double> vY2,std::vector<double> vZ1,std::vector<double> vZ2){
     
     double phi1, phi2, deltaPhi, zRecTracklets;
+
+    // The phi of the hits on the second detector is computed once per event, not once per pair
+    std::vector<double> vPhi2(vX2.size());
+    for(long unsigned int j=0;j<vX2.size();j++){
+        phi2=FastMath::Atan(vX2[j]/vY2[j]);
+        if(vX2[j]<0) phi2=phi2+TMath::Pi();
+        else if (vX2[j]>0 && vY2[j]<0) phi2=phi2 + 2*TMath::Pi();
+        vPhi2[j]=phi2;
+    }
+
     for(long unsigned int i=0;i<vX1.size();i++){ // 2 loops: on the first and second detector. All the hits on the 2 detectors are considered
-        for(long unsigned int j=0;j<vX2.size();j++){
-            phi1=atan(vX1[i]/vY1[i]);
-            if(vX1[i]<0) phi1=phi1+TMath::Pi();
-            else if (vX1[i]>0 && vY1[i]<0) phi1=phi1 + 2*TMath::Pi();
+        phi1=FastMath::Atan(vX1[i]/vY1[i]);
+        if(vX1[i]<0) phi1=phi1+TMath::Pi();
+        else if (vX1[i]>0 && vY1[i]<0) phi1=phi1 + 2*TMath::Pi();
 
-            phi2=atan(vX2[j]/vY2[j]);
-            if(vX2[j]<0) phi2=phi2+TMath::Pi();
-            else if (vX2[j]>0 && vY2[j]<0) phi2=phi2 + 2*TMath::Pi();
+        for(long unsigned int j=0;j<vX2.size();j++){
+            phi2=vPhi2[j];
 
             deltaPhi=abs(phi2-phi1);
             if(deltaPhi<=deltaPhiMax){   // If deltaPhi between the hits on the 2 detectors is lower than DeltaPhiMax, the intersection with z axis is calculated
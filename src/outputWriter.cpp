@@ -0,0 +1,75 @@
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include "../inc/outputWriter.h"
+
+OutputWriter::OutputWriter(std::function<void(EventRecord &)> fillFunction, unsigned long int batchSize)
+{
+    fill = fillFunction;
+    batch = batchSize;
+    frontBuffer.reserve(batch);
+    backBuffer.reserve(batch);
+    writerThread = std::thread(&OutputWriter::WriterLoop, this);
+}
+
+OutputWriter::~OutputWriter()
+{
+    Close();
+}
+
+void OutputWriter::Submit(EventRecord &&record)
+{
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    frontBuffer.push_back(std::move(record));
+    if (frontBuffer.size() >= batch) SwapBuffers(lock);
+}
+
+void OutputWriter::SwapBuffers(std::unique_lock<std::mutex> &lock)
+{
+    //Wait until the writer thread has emptied the back buffer
+    bufferCondition.wait(lock, [this]{return !backBufferReady;});
+    frontBuffer.swap(backBuffer);
+    backBufferReady = true;
+    bufferCondition.notify_all();
+}
+
+void OutputWriter::Close()
+{
+    if (!writerThread.joinable()) return;
+
+    {
+        std::unique_lock<std::mutex> lock(bufferMutex);
+        if (!frontBuffer.empty()) SwapBuffers(lock);
+        stop = true;
+        bufferCondition.notify_all();
+    }
+    writerThread.join();
+}
+
+void OutputWriter::WriterLoop()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(bufferMutex);
+            bufferCondition.wait(lock, [this]{return backBufferReady || stop;});
+            if (!backBufferReady && stop) return;
+        }
+
+        //The back buffer belongs to this thread until backBufferReady is reset
+        for (unsigned long int i = 0; i < backBuffer.size(); ++i)
+            fill(backBuffer[i]);
+        backBuffer.clear();
+
+        {
+            std::unique_lock<std::mutex> lock(bufferMutex);
+            backBufferReady = false;
+            bufferCondition.notify_all();
+        }
+    }
+}
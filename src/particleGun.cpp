@@ -14,33 +14,29 @@
 
 ParticleGun::ParticleGun()
 {
-   particleIDGenerator = 0;
+
 }
 
 ParticleGun::ParticleGun(ProgramConfig * conf)
 {
     ImportConfig(conf);
-    particleIDGenerator = 0;
 }
 
 ParticleGun::ParticleGun(RndEngine * rnde, ProgramConfig * conf)
 {
     ImportConfig(conf);
     SetRandomEngine(rnde);
-    particleIDGenerator = 0;
 }
 
 ParticleGun::ParticleGun(RndEngine * rnde)
 {
     SetRandomEngine(rnde);
-    particleIDGenerator = 0;
 }
 
 ParticleGun::ParticleGun(RndEngine * rnde, EventManager * currentEventObject)
 {
     SetRandomEngine(rnde);
     SetCurrentEvent(currentEventObject);
-    particleIDGenerator = 0;
 }
 
 ParticleGun::ParticleGun(RndEngine * rnde, EventManager * currentEventObject, ProgramConfig * conf)
@@ -48,7 +44,6 @@ ParticleGun::ParticleGun(RndEngine * rnde, EventManager * currentEventObject, Pr
     SetRandomEngine(rnde);
     SetCurrentEvent(currentEventObject);
     ImportConfig(conf);
-    particleIDGenerator = 0;
 }
 
 ParticleGun::~ParticleGun()
@@ -58,17 +53,31 @@ ParticleGun::~ParticleGun()
 
 void ParticleGun::ImportConfig(ProgramConfig * conf)
 {
-    //Import the pointers to the input distributions from the configuration file
+    //Import the pointers to the input distributions from the configuration file (the histogram samplers are built by ProgramConfig::PrepareSampling at the beginning of the run)
     disableKin                  = conf->disableKin;
-    momentumDistribution        = conf->momentumDistribution;
-    etaDistribution             = conf->etaDistribution;         
-    multiplicityDistribution    = conf->multiplicityDistribution;
-    phiDistribution             = conf->phiDistribution;         
-    bunchCrossingX              = conf->bunchCrossingX;          
-    bunchCrossingY              = conf->bunchCrossingY;         
-    zPosDistribution            = conf->zPosDistribution; 
+    momentumDistribution        = &conf->samplers.momentum;
+    etaDistribution             = &conf->samplers.eta;
+    multiplicityDistribution    = &conf->samplers.multiplicity;
+    phiDistribution             = &conf->samplers.phi;
+    bunchCrossingX              = &conf->samplers.bunchCrossingX;
+    bunchCrossingY              = &conf->samplers.bunchCrossingY;
+    zPosDistribution            = &conf->samplers.zPos;
     charge                      = conf->charge;
     mass                        = conf->mass;
+
+    //Sensitive layers seen by the acceptance prefilter
+    acceptancePrefilter = conf->acceptancePrefilter;
+    FastMath::SinCos(conf->acceptanceMargin, sinMargin, cosMargin);
+    acceptanceRMin.clear();
+    acceptanceRMax.clear();
+    acceptanceHalfLength.clear();
+    for (const LayerConfig &layer : conf->GetLayers())
+    {
+        if (!layer.sensitive) continue;
+        acceptanceRMin.push_back(layer.radius - layer.thickness / 2);
+        acceptanceRMax.push_back(layer.radius + layer.thickness / 2);
+        acceptanceHalfLength.push_back(layer.length / 2);
+    }
 }
 
 void ParticleGun::SetRandomEngine(RndEngine * rnde)
@@ -85,41 +94,37 @@ void ParticleGun::GenerateCollision()
 {
     //Generate multiplicity from distribution and vertex position
 
-    unsigned int mult = (unsigned int)multiplicityDistribution->GetRandom(rndEngine);
-    double vrtX = bunchCrossingX->GetRandom(rndEngine);
-    double vrtY = bunchCrossingY->GetRandom(rndEngine);
-    double vrtZ = zPosDistribution->GetRandom(rndEngine);
+    unsigned int mult = InputDistribution::SampleCount(*multiplicityDistribution, rndEngine);
+    double vrtX = InputDistribution::Sample(*bunchCrossingX, rndEngine);
+    double vrtY = InputDistribution::Sample(*bunchCrossingY, rndEngine);
+    double vrtZ = InputDistribution::Sample(*zPosDistribution, rndEngine);
 
-    //Fill the TTree
-    RunManager * ttree = currentEvent->GetRun();
+    //Add the vertex to the event record, it will be written in the TTree by the RunManager
     currentEvent->SetVertex(vrtX, vrtY, vrtZ);
-    ttree->GetBranch("PrimaryVertex")->SetAddress(&vert.X);
-    vert.X = vrtX;
-    vert.Y = vrtY;
-    vert.Z = vrtZ;
-    vert.eventID = currentEvent->GetEventID();
-    ULong64_t evento = currentEvent->GetEventID();
-    vert.mult = mult;
-    ttree->GetBranch("PrimaryVertex")->Fill();
+    Vertex vertex;
+    vertex.X = vrtX;
+    vertex.Y = vrtY;
+    vertex.Z = vrtZ;
+    vertex.eventID = currentEvent->GetEventID();
+    vertex.mult = mult;
+    currentEvent->record.vertices.push_back(vertex);
+    currentEvent->record.primaries += mult;
     //std::cerr << "\nPGUN -> injection, mult = " << mult;
 
-    //Iterate over tracks
-    for (unsigned int i = 0; i < mult; ++i)
+    //The kinematics is drawn in bulk for both kinds of events, so that a persistent event has the same primaries as in a non persistent run
+    SampleKinematics(mult);
+
+    //Non persistent events: the states of the whole collision are written at once. The persistent ones keep all their tracks (no acceptance prefilter) for the event display
+    if (!currentEvent->IsPersist())
     {
-        //Generate track parameters from the input distributions
-        double momentum;
-        if (disableKin)
-            momentum = 1e-19;
-        else
-            momentum = momentumDistribution->GetRandom(rndEngine);
-        
-        double eta = etaDistribution->GetRandom(rndEngine);
-        double phi = phiDistribution->GetRandom(rndEngine);
-
-        //Add the track to the event
-        GeneratePrimaryTrack(vrtZ, vrtX, vrtY, eta, phi, momentum, mass, charge);
+        GeneratePrimaries(mult, vrtX, vrtY, vrtZ);
+        return;
     }
 
+    //Iterate over tracks
+    for (unsigned int i = 0; i < mult; ++i)
+        GeneratePrimaryTrack(vrtZ, vrtX, vrtY, etas[i], phis[i], momenta[i], mass, charge);
+
     //Add to the caller runManager TTree all the information
     RunManager * currentRun = currentEvent->runManager;
 }
@@ -127,14 +132,19 @@ void ParticleGun::GenerateCollision()
 void ParticleGun::GeneratePrimaryTrack(Double_t zpos, Double_t xpos, Double_t ypos, Double_t eta, Double_t azimuth, Double_t momentum, Double_t mass, Double_t charge)
 {
     Double_t px, py, pz;
-    Double_t theta = 2 * TMath::ATan(TMath::Exp(-1. * eta));
 
-    px = momentum * TMath::Sin(theta) * TMath::Cos(azimuth); 
-    py = momentum * TMath::Sin(theta) * TMath::Sin(azimuth);
-    pz = momentum * TMath::Cos(theta);
+    //theta = 2 atan(exp(-eta)), from the identities sin(theta) = 1/cosh(eta) and cos(theta) = tanh(eta)
+    Double_t sinTheta, cosTheta, sinPhi, cosPhi;
+    FastMath::EtaToPolar(eta, sinTheta, cosTheta);
+    FastMath::SinCos(azimuth, sinPhi, cosPhi);
 
+    //Only persistent events build Track objects, the primaries of the other events are generated by GeneratePrimaries
+    px = momentum * sinTheta * cosPhi;
+    py = momentum * sinTheta * sinPhi;
+    pz = momentum * cosTheta;
 
-    Track * tr = new Track(GetParticleID());
+
+    Track * tr = currentEvent->NewTrack(GetParticleID());
     tr->SetMomentum(px, py, pz);
     tr->SetElectricalCharge(charge);
     tr->SetMass(mass);
@@ -148,8 +158,81 @@ void ParticleGun::GeneratePrimaryTrack(Double_t zpos, Double_t xpos, Double_t yp
     currentEvent->tracks.push_back(tr);
 }
 
+void ParticleGun::SampleKinematics(unsigned int mult)
+{
+    //Each distribution is sampled for all the particles with a single bulk draw
+    momenta.resize(mult);
+    etas.resize(mult);
+    phis.resize(mult);
+    if (disableKin)
+        std::fill(momenta.begin(), momenta.end(), 1e-19);
+    else
+        InputDistribution::SampleArray(*momentumDistribution, mult, momenta.data(), rndEngine);
+    InputDistribution::SampleArray(*etaDistribution, mult, etas.data(), rndEngine);
+    InputDistribution::SampleArray(*phiDistribution, mult, phis.data(), rndEngine);
+}
+
+void ParticleGun::GeneratePrimaries(unsigned int mult, Double_t xpos, Double_t ypos, Double_t zpos)
+{
+    //Consecutive particle IDs, reserved with a single update of the shared counter (the rejected particles keep their ID)
+    unsigned long int firstID = particleIDGenerator.fetch_add(mult) + 1;
+
+    //The directions are computed with the vectorized array kernels of FastMath (same values as the scalar ones of GeneratePrimaryTrack), and the states are initialized in place
+    sinThetas.resize(mult);
+    cosThetas.resize(mult);
+    sinPhis.resize(mult);
+    cosPhis.resize(mult);
+    FastMath::EtaToPolarArray(mult, etas.data(), sinThetas.data(), cosThetas.data());
+    FastMath::SinCosArray(mult, phis.data(), sinPhis.data(), cosPhis.data());
+
+    std::vector<TrackState> &states = currentEvent->trackStates;
+    unsigned long int first = states.size();
+    unsigned int accepted = 0;
+    states.resize(first + mult);
+    for (unsigned int i = 0; i < mult; ++i)
+    {
+        Double_t sinTheta = sinThetas[i], cosTheta = cosThetas[i];
+
+        //Particles that cannot produce a sensitive hit are not transported
+        if (acceptancePrefilter && !InAcceptance(xpos, ypos, zpos, sinTheta, cosTheta)) continue;
+
+        InitTrackState(states[first + accepted], xpos, ypos, zpos, sinTheta * cosPhis[i], sinTheta * sinPhis[i], cosTheta, momenta[i], mass, firstID + i);
+        ++accepted;
+    }
+    states.resize(first + accepted);
+
+    currentEvent->record.rejectedPrimaries += mult - accepted;
+}
+
+bool ParticleGun::InAcceptance(Double_t xpos, Double_t ypos, Double_t zpos, Double_t sinTheta, Double_t cosTheta)
+{
+    //Polar angle widened by the margin: cot(theta - margin) and cot(theta + margin), unbounded beyond the beam axis
+    Double_t sinLow = sinTheta * cosMargin - cosTheta * sinMargin;
+    Double_t cosLow = cosTheta * cosMargin + sinTheta * sinMargin;
+    Double_t sinHigh = sinTheta * cosMargin + cosTheta * sinMargin;
+    Double_t cosHigh = cosTheta * cosMargin - sinTheta * sinMargin;
+    Double_t cotMax = (sinLow > 0) ? cosLow / sinLow : 1e30;
+    Double_t cotMin = (sinHigh > 0) ? cosHigh / sinHigh : -1e30;
+
+    //Transverse path from the vertex to a layer of radius R, for any azimuth: R - rho ... R + rho
+    Double_t rho = TMath::Sqrt(xpos * xpos + ypos * ypos);
+    for (unsigned int k = 0; k < acceptanceHalfLength.size(); ++k)
+    {
+        Double_t sLow = std::max(acceptanceRMin[k] - rho, 0.);
+        Double_t sHigh = acceptanceRMax[k] + rho;
+        Double_t zLow = zpos + std::min(sLow * cotMin, sHigh * cotMin);
+        Double_t zHigh = zpos + std::max(sLow * cotMax, sHigh * cotMax);
+        if (zLow <= acceptanceHalfLength[k] && zHigh >= -acceptanceHalfLength[k]) return true;
+    }
+    return false;
+}
+
 unsigned long int ParticleGun::GetParticleID()
 {
-    particleIDGenerator++;
-    return particleIDGenerator;
+    return ++particleIDGenerator;
+}
+
+void ParticleGun::ResetParticleID()
+{
+    particleIDGenerator = 0;
 }
\ No newline at end of file
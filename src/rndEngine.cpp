@@ -1,4 +1,3 @@
-
 /*
 *   Tecniche di Analisi Numerica e Simulazione
 *   Dipartimento di Fisica - Università degli Studi di Torino 
@@ -22,3 +21,138 @@ RndEngine::~RndEngine()
 {
     
 }
+
+void RndEngine::SetCounterBased(bool enable, ULong64_t seed)
+{
+    counterBased = enable;
+    key[0] = (UInt_t)(seed & 0xFFFFFFFF);
+    key[1] = (UInt_t)(seed >> 32);
+    SetEventStream(0, 0);
+}
+
+void RndEngine::SetEventStream(ULong64_t eventID, UInt_t stream)
+{
+    //Counter layout: [draw block, stream, eventID low word, eventID high word]
+    counter[0] = 0;
+    counter[1] = stream;
+    counter[2] = (UInt_t)(eventID & 0xFFFFFFFF);
+    counter[3] = (UInt_t)(eventID >> 32);
+    blockIndex = 4;
+}
+
+void RndEngine::SaveStream(StreamState &state)
+{
+    if (!counterBased) return;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        state.counter[i] = counter[i];
+        state.block[i] = block[i];
+    }
+    state.blockIndex = blockIndex;
+}
+
+void RndEngine::RestoreStream(const StreamState &state)
+{
+    if (!counterBased) return;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        counter[i] = state.counter[i];
+        block[i] = state.block[i];
+    }
+    blockIndex = state.blockIndex;
+}
+
+void RndEngine::PhiloxBlock()
+{
+    //Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11)
+    const ULong64_t M0 = 0xD2511F53;
+    const ULong64_t M1 = 0xCD9E8D57;
+    const UInt_t W0 = 0x9E3779B9;
+    const UInt_t W1 = 0xBB67AE85;
+
+    UInt_t x[4] = {counter[0], counter[1], counter[2], counter[3]};
+    UInt_t k0 = key[0];
+    UInt_t k1 = key[1];
+
+    for (unsigned int r = 0; r < 10; ++r)
+    {
+        ULong64_t p0 = M0 * x[0];
+        ULong64_t p1 = M1 * x[2];
+        UInt_t y0 = (UInt_t)(p1 >> 32) ^ x[1] ^ k0;
+        UInt_t y1 = (UInt_t)p1;
+        UInt_t y2 = (UInt_t)(p0 >> 32) ^ x[3] ^ k1;
+        UInt_t y3 = (UInt_t)p0;
+        x[0] = y0; x[1] = y1; x[2] = y2; x[3] = y3;
+        k0 += W0;
+        k1 += W1;
+    }
+
+    for (unsigned int i = 0; i < 4; ++i) block[i] = x[i];
+    blockIndex = 0;
+    counter[0]++;
+}
+
+Double_t RndEngine::Rndm()
+{
+    if (!counterBased) return TRandom3::Rndm();
+
+    if (blockIndex == 4) PhiloxBlock();
+
+    //Uniform in the open interval (0, 1), with the same 32 bit resolution of TRandom3
+    return (block[blockIndex++] + 0.5) * 2.3283064365386963e-10;
+}
+
+void RndEngine::RndmArray(Int_t n, Float_t * array)
+{
+    if (!counterBased)
+    {
+        TRandom3::RndmArray(n, array);
+        return;
+    }
+    for (Int_t i = 0; i < n; ++i) array[i] = (Float_t)Rndm();
+}
+
+void RndEngine::RndmArray(Int_t n, Double_t * array)
+{
+    if (!counterBased)
+    {
+        TRandom3::RndmArray(n, array);
+        return;
+    }
+
+    //Same numbers of Rndm, one Philox block at a time
+    Int_t i = 0;
+    while (i < n)
+    {
+        if (blockIndex == 4) PhiloxBlock();
+        while (blockIndex < 4 && i < n)
+            array[i++] = (block[blockIndex++] + 0.5) * 2.3283064365386963e-10;
+    }
+}
+
+void RndEngine::GausArray(Int_t n, Double_t * array)
+{
+    //Box-Muller: the pair of uniform numbers (u1, u2) gives the two normal numbers r cos(2 pi u2) and r sin(2 pi u2), r = sqrt(-2 ln u1)
+    //The sine and cosine of the angles of a chunk are computed together with the vectorized FastMath::SinCosArray
+    const Int_t kChunk = 64;
+    Double_t u[kChunk];
+    Double_t angle[kChunk / 2], s[kChunk / 2], c[kChunk / 2];
+
+    for (Int_t first = 0; first < n; first += kChunk)
+    {
+        Int_t m = TMath::Min(kChunk, n - first);
+        Int_t nPairs = (m + 1) / 2;
+        RndmArray(2 * nPairs, u);
+
+        for (Int_t k = 0; k < nPairs; ++k) angle[k] = 2 * TMath::Pi() * u[2 * k + 1];
+        FastMath::SinCosArray(nPairs, angle, s, c);
+
+        Double_t * out = array + first;
+        for (Int_t k = 0; k < nPairs; ++k)
+        {
+            Double_t r = TMath::Sqrt(-2. * TMath::Log(u[2 * k]));
+            out[2 * k] = r * c[k];
+            if (2 * k + 1 < m) out[2 * k + 1] = r * s[k];
+        }
+    }
+}
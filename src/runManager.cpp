@@ -29,7 +29,8 @@ RunManager::RunManager(ProgramConfig * configuration, TFile * simulationCurrentF
 
     //Initialize the random engine to be used for this run
     rndEngine = new RndEngine();
-    rndEngine->SetSeed(conf->rndSeed);
+    rndEngine->SetSeed(conf->GetShardSeed());
+    rndEngine->SetCounterBased(conf->counterBasedRandom, conf->GetShardSeed());
 
     //Open the ROOT working file on HDD and set it as the working directory
     simCurrentFile = simulationCurrentFile;
@@ -41,6 +42,7 @@ RunManager::RunManager(ProgramConfig * configuration, TFile * simulationCurrentF
     experimentSimulation = new ExperimentSimulation();
     experimentSimulation->SetConfiguration(conf);
     experimentSimulation->SetHitTree(this);
+    experimentSimulation->SetRndEngine(rndEngine);
     TransportEngine::SetRandomEngine(rndEngine);
 
     //Build the detector geometry
@@ -48,12 +50,21 @@ RunManager::RunManager(ProgramConfig * configuration, TFile * simulationCurrentF
 
     //Initialize the ParticleGun class istance that will generate the primary tracks from a vertex inside a given event
     particleGun = new ParticleGun(rndEngine, conf);
+    ParticleGun::ResetParticleID();
 
     //Initialize the DetectorEffects class istance that will simulate the noise effects due to soft particles and silicon pixel dark counts
     //Load the configuration inside the detectorEffects object
     detectorEffects = new DetectorEffects(rndEngine);
     detectorEffects->LoadConfiguration(conf);
 
+    //The objects above are the ones used by the first (or only) worker
+    SimulationWorker mainWorker;
+    mainWorker.rndEngine = rndEngine;
+    mainWorker.particleGun = particleGun;
+    mainWorker.experimentSimulation = experimentSimulation;
+    mainWorker.detectorEffects = detectorEffects;
+    workers.push_back(mainWorker);
+
     std::cerr << "\nInitialization completed.";
 }
 
@@ -61,8 +72,10 @@ RunManager::~RunManager()
 {
     //Save buffered data on TFile and close TFile
     FlushMemory();
+    FreeWorkers();
     delete particleGun;
     delete experimentSimulation;
+    delete detectorEffects;
     delete rndEngine;
 }
 
@@ -91,109 +104,408 @@ void RunManager::BeamOn()
     tsw->Stop();
 
     //Print elapsed time
-    std::cerr << "\nRun completed. " << conf->eventNumber << " events in ";
+    std::cerr << "\nRun completed. " << conf->GetShardEventNumber() << " events in ";
     tsw->Print();
     delete tsw;
+
+    if (conf->acceptancePrefilter && conf->acceptanceTruthCount)
+        std::cerr << "\nAcceptance prefilter: " << rejectedPrimaries << " of " << writtenPrimaries << " primary particles outside the acceptance of the sensitive layers, not transported.";
 }
 
-void RunManager::SimulationBackend()
+void RunManager::AllocateWorkers(unsigned int nWorkers)
 {
-    //Check if single event persistence is enabled in the persistence file
-    bool persist = conf->singleEventPersistenceEnabled;
+    //Every additional worker gets its own random engine, particle gun, transport and detector effects.
+    //The geometry is rebuilt for each of them, since it is cheap and it is only read during the transport
+    for (unsigned int k = workers.size(); k < nWorkers; ++k)
+    {
+        SimulationWorker worker;
 
-    //Retrieve the number of events from the configuration file
-    unsigned long int eventNum = conf->eventNumber;
+        worker.rndEngine = new RndEngine();
+        worker.rndEngine->SetSeed(conf->GetShardSeed() + k);
+        worker.rndEngine->SetCounterBased(conf->counterBasedRandom, conf->GetShardSeed());
 
-    simCurrentFile->cd();
-    this->SetAutoFlush(100000);
-     
-    //Loop over all the events
-    for (unsigned long int i = 0; i < eventNum; ++i)
+        worker.experimentSimulation = new ExperimentSimulation();
+        worker.experimentSimulation->SetConfiguration(conf);
+        worker.experimentSimulation->SetHitTree(this);
+        worker.experimentSimulation->SetRndEngine(worker.rndEngine);
+        worker.experimentSimulation->physicsList = experimentSimulation->physicsList;
+        worker.experimentSimulation->BuildGeometry();
+        worker.experimentSimulation->SelectTransport();
+
+        worker.particleGun = new ParticleGun(worker.rndEngine, conf);
+
+        worker.detectorEffects = new DetectorEffects(worker.rndEngine);
+        worker.detectorEffects->LoadConfiguration(conf);
+
+        workers.push_back(worker);
+    }
+}
+
+void RunManager::FreeWorkers()
+{
+    //Worker 0 owns the objects of the RunManager itself, they are deallocated by the destructor
+    for (unsigned int k = 1; k < workers.size(); ++k)
     {
-        //Generate the current event, specify if it will be persistent (for memory allocation optimization)
-        EventManager * currentEvent = new EventManager();
-        currentEvent->SetPersist(persist);
-        currentEvent->runManager = this;
+        delete workers[k].particleGun;
+        delete workers[k].experimentSimulation;
+        delete workers[k].detectorEffects;
+        delete workers[k].rndEngine;
+    }
+    workers.resize(1);
+}
+
+EventManager * RunManager::SimulateEvent(SimulationWorker &worker, Int_t eventID)
+{
+    EventManager * currentEvent = GenerateEvent(worker, eventID);
+    TransportEvent(worker, currentEvent);
+    return currentEvent;
+}
+
+EventManager * RunManager::GenerateEvent(SimulationWorker &worker, Int_t eventID)
+{
+    //Generate the current event, specify if it will be persistent (for memory allocation optimization)
+    EventManager * currentEvent = new EventManager(eventID);
+    currentEvent->SetPersist(conf->singleEventPersistenceEnabled);
+    currentEvent->runManager = this;
+
+    //Set this event as active for the particle gun used by this worker
+    worker.particleGun->SetCurrentEvent(currentEvent);
+
+    //With the counter-based generator every stage of the event draws from its own (seed, eventID, stream) sequence
+    worker.rndEngine->SetEventStream(eventID, RndEngine::kGenerationStream);
+
+    //Some collisions! If a single collision per event is required
+    if (conf->singleCollisionInEvent)
+    {
+        worker.particleGun->GenerateCollision();
+    }
+    else
+    {
+        //If we need to simulate some pile-up, TH1D with the distribution of no. of collisions per events
+        unsigned int ncoll = InputDistribution::SampleCount(conf->samplers.collisionPerEvent, worker.rndEngine);
+        for (unsigned int k = 0; k < ncoll; ++k)
+            worker.particleGun->GenerateCollision();
+    }
+
+    return currentEvent;
+}
+
+void RunManager::TransportEvent(SimulationWorker &worker, EventManager * currentEvent)
+{
+    Int_t eventID = currentEvent->GetEventID();
 
-        //Set this event as active for the particle gun used in this run
-        particleGun->SetCurrentEvent(currentEvent);
-        
-        //Some collisions! If a single collision per event is required
-        if (conf->singleCollisionInEvent)
+    //Pass the current event to the ExperimentSimulation class istance that will compute particle transport and detector hits
+    worker.rndEngine->SetEventStream(eventID, RndEngine::kTransportStream);
+    worker.experimentSimulation->ProcessEvent(currentEvent);
+
+    ApplyDetectorEffects(worker, currentEvent);
+}
+
+void RunManager::ApplyDetectorEffects(SimulationWorker &worker, EventManager * currentEvent)
+{
+    //Pass the current event to the DetectorEffects class istance that will simulate soft particles and noise
+    worker.rndEngine->SetEventStream(currentEvent->GetEventID(), RndEngine::kDetectorStream);
+    if (conf->enableSoftParticlesNoise) worker.detectorEffects->SoftParticlePixelNoise(currentEvent);
+}
+
+void RunManager::SimulateBlock(SimulationWorker &worker, Int_t firstEventID, unsigned int nEvents, std::vector<EventManager *> &block)
+{
+    block.clear();
+    for (unsigned int k = 0; k < nEvents; ++k)
+        block.push_back(GenerateEvent(worker, firstEventID + k));
+
+    if (nEvents == 1)
+    {
+        TransportEvent(worker, block[0]);
+        return;
+    }
+
+    worker.experimentSimulation->ProcessEventBatch(block);
+    for (unsigned int k = 0; k < nEvents; ++k)
+        ApplyDetectorEffects(worker, block[k]);
+}
+
+unsigned int RunManager::GetBlockSize()
+{
+    //The batched transport does not build the Track and Hit objects stored by the persistent events
+    if (conf->transportBatchSize <= 1 || conf->singleEventPersistenceEnabled) return 1;
+    return conf->transportBatchSize;
+}
+
+void RunManager::FillRecord(EventRecord &record)
+{
+    //Copy the output of the event in the TTree, vertices first and then the sensitive detector hits
+    this->GetBranch("PrimaryVertex")->SetAddress(&vert.X);
+    for (unsigned long int j = 0; j < record.vertices.size(); ++j)
+    {
+        vert = record.vertices[j];
+        this->GetBranch("PrimaryVertex")->Fill();
+    }
+
+    this->GetBranch("DetectorHits")->SetAddress(&dhit.X);
+    for (unsigned long int j = 0; j < record.detHits.size(); ++j)
+    {
+        dhit = record.detHits[j];
+        this->GetBranch("DetectorHits")->Fill();
+    }
+
+    writtenPrimaries += record.primaries;
+    rejectedPrimaries += record.rejectedPrimaries;
+    unsigned long int i = writtenEvents++;
+
+    if ((i % 50000 == 0) && (i != 0))
+    {
+        this->FlushBaskets();
+        this->FlushMemory();
+        simCurrentFile->Flush();
+        std::cerr << "  -> Flushing tree baskets to the storage";
+    }
+
+
+    if ((i % 200000 == 0) && (i != 0))   // after debug 200000
+    {
+        this->FlushBaskets();
+        this->FlushMemory();
+        simCurrentFile->Flush();
+        this->AutoSave();
+        this->Write("PixelTracker");
+        this->Reset();
+        this->FlushMemory();
+        std::cerr << "  -> Writing objects";
+    }
+}
+
+void RunManager::CommitEvent(EventManager * currentEvent)
+{
+    //The writer thread takes the ownership of the event output, the event itself can be deallocated right away
+    if (outputWriter != nullptr)
+        outputWriter->Submit(std::move(currentEvent->record));
+    else
+        FillRecord(currentEvent->record);
+
+    //If single event persistence is enabled, store the event, otherwise cleanup
+    if(currentEvent->IsPersist())
+    {
+        //Save event data
+        events.push_back(currentEvent);
+        simCurrentFile->cd("events/");
+        currentEvent->Write();
+
+        //Save the tracks
+        for (unsigned long int j = 0; j < currentEvent->tracks.size(); ++j)
         {
-            particleGun->GenerateCollision();
+            simCurrentFile->cd("tracks/");
+            currentEvent->tracks[j]->Write();
         }
-        else
+
+        //Save the hits
+        for (unsigned long int j = 0; j < currentEvent->hits.size(); ++j)
         {
-            //If we need to simulate some pile-up, TH1D with the distribution of no. of collisions per events
-            int ncoll = conf->collisionPerEventDistribution->GetRandom(rndEngine);
-            for (int k = 0; k < ncoll; ++k)
-                particleGun->GenerateCollision();
+            simCurrentFile->cd("hits/");
+            currentEvent->hits[j]->Write();
         }
 
-        
+    }
+    else
+    {
+        delete currentEvent;
+    }
 
-        //Pass the current event to the ExperimentSimulation class istance that will compute particle transport and detector hits
-        experimentSimulation->ProcessEvent(currentEvent);
-        //std::cerr << "\nEVENT = " << currentEvent->GetEventID();
+    unsigned long int i = committedEvents++;
 
-        //Pass the current event to the DetectorEffects class istance that will simulate soft particles and noise
-        if (conf->enableSoftParticlesNoise) detectorEffects->SoftParticlePixelNoise(currentEvent);
+    if (i % conf->reportEvery == 0)
+        std::cerr << "\nEvent " << i << " completed.  ";
+}
 
+void RunManager::WorkerLoop(unsigned int workerIndex)
+{
+    SimulationWorker &worker = workers[workerIndex];
+    unsigned long int eventNum = conf->GetShardEventNumber();
+    unsigned long int firstEvent = conf->GetShardFirstEvent();
+
+    //Events are pulled one block at a time, so that a worker stuck on a high multiplicity event does not hold back the others
+    unsigned int blockSize = GetBlockSize();
+    std::vector<EventManager *> block;
+    unsigned long int i;
+    while ((i = nextEvent.fetch_add(blockSize)) < eventNum)
+    {
+        unsigned int n = std::min<unsigned long int>(blockSize, eventNum - i);
+        SimulateBlock(worker, firstEvent + i + 1, n, block);
 
-        //If single event persistence is enabled, store the event, otherwise cleanup
-        if(persist)
-        {
+        std::lock_guard<std::mutex> lock(commitMutex);
+        for (unsigned int k = 0; k < n; ++k)
+            CommitEvent(block[k]);
+    }
+}
 
-            //Save event data
-            events.push_back(currentEvent);
-            simCurrentFile->cd("events/");
-            currentEvent->Write();
-
-            //Save the tracks
-            for (unsigned long int i = 0; i < currentEvent->tracks.size(); ++i)
-            {
-                simCurrentFile->cd("tracks/");
-                currentEvent->tracks[i]->Write();
-            }
-
-            //Save the hits
-            for (unsigned long int i = 0; i < currentEvent->hits.size(); ++i)
-            {
-                simCurrentFile->cd("hits/");
-                currentEvent->hits[i]->Write();
-            }
+void RunManager::GenerationStage(std::vector<RingQueue<EventManager *> *> &transportQueues)
+{
+    unsigned long int eventNum = conf->GetShardEventNumber();
+    unsigned long int firstEvent = conf->GetShardFirstEvent();
+    unsigned int nStages = transportQueues.size();
 
-        }
-        else
-        {
-            delete currentEvent;
-        }
+    //Events are dealt round-robin, so that the output stage can restore their order
+    for (unsigned long int i = 0; i < eventNum; ++i)
+    {
+        EventManager * currentEvent = GenerateEvent(workers[0], firstEvent + i + 1);
+        transportQueues[i % nStages]->WaitPush(currentEvent);
+    }
 
-        if (i % conf->reportEvery == 0)
-            std::cerr << "\nEvent " << i << " completed.  ";
+    //End of run marker
+    for (unsigned int k = 0; k < nStages; ++k)
+        transportQueues[k]->WaitPush(nullptr);
+}
+
+void RunManager::TransportStage(unsigned int workerIndex, RingQueue<EventManager *> * inQueue, RingQueue<EventManager *> * outQueue)
+{
+    SimulationWorker &worker = workers[workerIndex];
+    EventManager * currentEvent;
+
+    while (true)
+    {
+        inQueue->WaitPop(currentEvent);
+        if (currentEvent != nullptr) TransportEvent(worker, currentEvent);
+        outQueue->WaitPush(currentEvent);
+        if (currentEvent == nullptr) return;
+    }
+}
 
-        if ((i % 50000 == 0) && (i != 0))
+void RunManager::PipelineBackend(unsigned int nStages)
+{
+    const unsigned long int queueCapacity = 256;
+
+    //Worker 0 generates the collisions, workers 1..nStages transport them
+    ROOT::EnableThreadSafety();
+    AllocateWorkers(nStages + 1);
+    std::cerr << "\nSimulation running in pipelined mode with " << nStages << " transport stages.";
+
+    std::vector<RingQueue<EventManager *> *> transportQueues;
+    std::vector<RingQueue<EventManager *> *> outputQueues;
+    for (unsigned int k = 0; k < nStages; ++k)
+    {
+        transportQueues.push_back(new RingQueue<EventManager *>(queueCapacity));
+        outputQueues.push_back(new RingQueue<EventManager *>(queueCapacity));
+    }
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(&RunManager::GenerationStage, this, std::ref(transportQueues));
+    for (unsigned int k = 0; k < nStages; ++k)
+        threads.emplace_back(&RunManager::TransportStage, this, k + 1, transportQueues[k], outputQueues[k]);
+
+    //Output stage: all the TTree filling and file I/O stay on this thread, the events are read back in round-robin order
+    unsigned int finishedStages = 0;
+    unsigned long int i = 0;
+    while (finishedStages < nStages)
+    {
+        EventManager * currentEvent;
+        outputQueues[i % nStages]->WaitPop(currentEvent);
+        ++i;
+        if (currentEvent == nullptr)
         {
-            this->FlushBaskets();
-            this->FlushMemory();
-            simCurrentFile->Flush();
-            std::cerr << "  -> Flushing tree baskets to the storage";
+            finishedStages++;
+            continue;
         }
+        CommitEvent(currentEvent);
+    }
+
+    for (unsigned int k = 0; k < threads.size(); ++k)
+        threads[k].join();
+
+    for (unsigned int k = 0; k < nStages; ++k)
+    {
+        delete transportQueues[k];
+        delete outputQueues[k];
+    }
+    FreeWorkers();
+}
+
+void RunManager::SimulationBackend()
+{
+    //Check if single event persistence is enabled in the persistence file
+    bool persist = conf->singleEventPersistenceEnabled;
+
+    //Retrieve the number of events from the configuration file, restricted to the event ID range of this shard
+    unsigned long int eventNum = conf->GetShardEventNumber();
+    unsigned long int firstEvent = conf->GetShardFirstEvent();
+    if (conf->nShards > 1)
+        std::cerr << "\nShard " << conf->shardIndex << "/" << conf->nShards << ": event IDs " << firstEvent + 1 << " - " << firstEvent + eventNum;
+
+    //Retrieve the number of worker threads from the configuration file
+    unsigned int nThreads = conf->nThreads;
+    if (nThreads == 0) nThreads = 1;
+    unsigned int pipelineStages = conf->pipelineStages;
+    if (persist && nThreads > 1)
+    {
+        std::cerr << "\nWarning: single event persistence requires a single worker thread, nThreads=" << nThreads << " ignored.";
+        nThreads = 1;
+    }
+    if (persist && pipelineStages > 0)
+    {
+        std::cerr << "\nWarning: single event persistence requires a single worker thread, pipelineStages=" << pipelineStages << " ignored.";
+        pipelineStages = 0;
+    }
+
+    simCurrentFile->cd();
+    this->SetAutoFlush(100000);
+    committedEvents = 0;
+    writtenEvents = 0;
+    writtenPrimaries = 0;
+    rejectedPrimaries = 0;
+
+    //Alias samplers of the input histograms, shared by all the workers
+    conf->PrepareSampling();
 
+    //The transport of the main worker is specialized on the physics options of this run (the other workers select it when allocated)
+    experimentSimulation->SelectTransport();
 
-        if ((i % 200000 == 0) && (i != 0))   // after debug 200000
+    //The persistent events are written in the TFile by the simulation thread, so they cannot share it with a writer thread
+    if (conf->asyncOutput && !persist)
+    {
+        ROOT::EnableThreadSafety();
+        outputWriter = new OutputWriter([this](EventRecord &record){FillRecord(record);});
+    }
+     
+    if (pipelineStages > 0)
+    {
+        PipelineBackend(pipelineStages);
+    }
+    else if (nThreads == 1)
+    {
+        //Loop over all the events, one block at a time
+        unsigned int blockSize = GetBlockSize();
+        std::vector<EventManager *> block;
+        for (unsigned long int i = 0; i < eventNum; i += blockSize)
         {
-            this->FlushBaskets();
-            this->FlushMemory();
-            simCurrentFile->Flush();
-            this->AutoSave();
-            this->Write("PixelTracker");
-            this->Reset();
-            this->FlushMemory();
-            std::cerr << "  -> Writing objects";
+            unsigned int n = std::min<unsigned long int>(blockSize, eventNum - i);
+            SimulateBlock(workers[0], firstEvent + i + 1, n, block);
+            for (unsigned int k = 0; k < n; ++k)
+                CommitEvent(block[k]);
         }
     }
+    else
+    {
+        ROOT::EnableThreadSafety();
+        AllocateWorkers(nThreads);
+        std::cerr << "\nSimulation running on " << nThreads << " worker threads.";
+
+        nextEvent = 0;
+        std::vector<std::thread> threads;
+        for (unsigned int k = 0; k < nThreads; ++k)
+            threads.emplace_back(&RunManager::WorkerLoop, this, k);
+
+        for (unsigned int k = 0; k < nThreads; ++k)
+            threads[k].join();
+
+        FreeWorkers();
+    }
+
+    //Wait for the writer thread, from now on the TFile is accessed by this thread only
+    if (outputWriter != nullptr)
+    {
+        outputWriter->Close();
+        delete outputWriter;
+        outputWriter = nullptr;
+    }
 
     //Save the sensitive detector hit (FAST2 sim data) recorded in the TTree
     this->StartViewer();
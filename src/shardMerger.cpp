@@ -0,0 +1,141 @@
+/*
+*   Tecniche di Analisi Numerica e Simulazione
+*   Dipartimento di Fisica - Università degli Studi di Torino 
+*   Authors: Enrica Bergalla e Valerio Pagliarino
+*   Title: Software di simulazione Monte Carlo e ricostruzione di vertici 
+*   Date: December 2022 - Licenza Creative Commons CC BY-SA 3.0 IT
+*/
+
+#include "../inc/shardMerger.h"
+
+ShardMerger::ShardMerger(ProgramConfig * config)
+{
+    conf = config;
+}
+
+ShardMerger::~ShardMerger()
+{
+
+}
+
+bool ShardMerger::Merge()
+{
+    bool status = true;
+    particleIDOffset = 0;
+
+    //Same layout of the TTree written by the RunManager
+    TFile * outFile = new TFile(conf->simRootFileName.c_str(), "RECREATE");
+    outTree = new TTree("PixelTracker", "");
+    outTree->SetDirectory(outFile);
+    outTree->Branch("PrimaryVertex", &outVert.X, "X/D:Y/D:Z/D:mult/I:eventID/I");
+    outTree->Branch("DetectorHits", &outHit.X, "X/D:Y/D:Z/D:eventID/l:particleID/l:detectorID/l");
+    outTree->SetAutoFlush(100000);
+
+    unsigned int nShards = conf->nShards;
+    unsigned int shardIndex = conf->shardIndex;
+
+    for (unsigned int k = 0; k < nShards; ++k)
+    {
+        std::string shardFileName = conf->GetShardFileName(k);
+        TFile * shardFile = new TFile(shardFileName.c_str(), "READ");
+        if (shardFile->IsZombie())
+        {
+            std::cerr << "\nError: shard file " << shardFileName << " not found.";
+            status = false;
+            delete shardFile;
+            continue;
+        }
+
+        //The expected event ID range of each shard is recomputed from the configuration
+        conf->shardIndex = k;
+        if (!MergeShard(shardFile, k)) status = false;
+        std::cerr << "\nMerged shard " << k << " from " << shardFileName;
+
+        shardFile->Close();
+        delete shardFile;
+    }
+    conf->shardIndex = shardIndex;
+
+    outFile->cd();
+    outTree->Write("PixelTracker", kOverwrite);
+    outFile->Close();
+    delete outFile;
+
+    if (status) std::cerr << "\nMerge completed: " << conf->simRootFileName;
+    else std::cerr << "\nMerge completed with errors: " << conf->simRootFileName;
+    return status;
+}
+
+bool ShardMerger::MergeShard(TFile * shardFile, unsigned int index)
+{
+    Vertex inVert;
+    DetHit inHit;
+    ULong64_t maxParticleID = 0;
+    Long64_t minEventID = -1;
+    Long64_t maxEventID = -1;
+    unsigned long int nVertices = 0;
+    char ttreeName[60];
+
+    //Count the versions of the PixelTracker TTree inside the shard file, as the reconstruction does
+    int count = 0;
+    TKey * key;
+    TIter nextkey(shardFile->GetListOfKeys());
+    while((key = (TKey*)nextkey()))
+    {
+        if (strcmp(key->GetName(),"PixelTracker")==0) count++;
+    }
+
+    for (int l = 1; l <= count; l++)
+    {
+        sprintf(ttreeName,"PixelTracker;%d",l);
+        TTree * tree = (TTree*)shardFile->Get(ttreeName);
+        if (tree == nullptr) continue;
+
+        TBranch * branchVert = tree->GetBranch("PrimaryVertex");
+        branchVert->SetAddress(&inVert.X);
+        Long64_t nv = branchVert->GetEntries();
+        for (Long64_t j = 0; j < nv; ++j)
+        {
+            branchVert->GetEntry(j);
+            outVert = inVert;
+            outTree->GetBranch("PrimaryVertex")->Fill();
+
+            if (minEventID < 0 || inVert.eventID < minEventID) minEventID = inVert.eventID;
+            if (inVert.eventID > maxEventID) maxEventID = inVert.eventID;
+            nVertices++;
+        }
+
+        TBranch * branchHits = tree->GetBranch("DetectorHits");
+        branchHits->SetAddress(&inHit.X);
+        Long64_t nh = branchHits->GetEntries();
+        for (Long64_t j = 0; j < nh; ++j)
+        {
+            branchHits->GetEntry(j);
+            outHit = inHit;
+
+            //Particle IDs restart from 1 in every shard, noise hits (particleID = 0) are left untouched
+            if (inHit.particleID != 0)
+            {
+                outHit.particleID = inHit.particleID + particleIDOffset;
+                if (inHit.particleID > maxParticleID) maxParticleID = inHit.particleID;
+            }
+            outTree->GetBranch("DetectorHits")->Fill();
+        }
+
+        delete tree;
+    }
+
+    particleIDOffset += maxParticleID;
+
+    //Check that the shard covers exactly its event ID range (single collision per event)
+    Long64_t expectedFirst = conf->GetShardFirstEvent() + 1;
+    Long64_t expectedLast = conf->GetShardFirstEvent() + conf->GetShardEventNumber();
+    if (nVertices == 0) return conf->GetShardEventNumber() == 0;
+    if (minEventID != expectedFirst || maxEventID != expectedLast)
+    {
+        std::cerr << "\nWarning: shard " << index << " contains event IDs " << minEventID << " - " << maxEventID;
+        std::cerr << ", expected " << expectedFirst << " - " << expectedLast;
+        return false;
+    }
+    return true;
+}
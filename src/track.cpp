@@ -26,9 +26,10 @@ Track::Track(const Track &Particle) : TObject()
     SetTrackStop(Particle.bx, Particle.by, Particle.bz);
     SetMomentum(Particle.px, Particle.py, Particle.pz);
     SetElectricalCharge(Particle.q);
-    SetMass(Particle.q);
+    SetMass(Particle.m);
     SetEvent(Particle.currentEvent, Particle.eventID);
     trackingActive = Particle.trackingActive;
+    noStop = Particle.noStop;
     particleID = Particle.particleID;
 }
 
@@ -207,7 +208,7 @@ Double_t Track::GetVelocityZ()
 Double_t Track::GetGamma()
 {
     Double_t p2 = px*px + py*py + pz*pz;
-    return TMath::Sqrt(1 + p2/(m*m*c*c));
+    return TMath::Sqrt(1 + p2/(m*m*(Units::c*Units::c)));
 }
 
 Double_t Track::GetBeta()
@@ -219,5 +220,5 @@ Double_t Track::GetBeta()
 Double_t Track::GetEnergy()
 {
     Double_t p2 = px * px + py * py + pz * pz; 
-    return TMath::Sqrt(m*m*c*c*c*c + p2*c*c); 
+    return TMath::Sqrt((m*m*(Units::c*Units::c) + p2)*(Units::c*Units::c));
 }
\ No newline at end of file
@@ -24,7 +24,7 @@ void TransportEngine::SetRandomEngine(RndEngine * rndE)
     rndEngine = rndE;
 }
 
-void TransportEngine::MultipleScattering(Track * incomingTrack, Track * &outgoingTrack, TVector3 * interactionPoint, Int_t zMat, Double_t x, Double_t xr, bool thetaMsAp, bool kinematics)
+void TransportEngine::MultipleScattering(Track * incomingTrack, Track * &outgoingTrack, TVector3 * interactionPoint, Double_t highlandConstant, bool thetaMsAp, bool kinematics, RandomBuffer * random)
 {
     //Compute the offset due to multiple scattering in thick material
     Double_t deltaX, deltaY, deltaZ;
@@ -50,29 +50,15 @@ void TransportEngine::MultipleScattering(Track * incomingTrack, Track * &outgoin
     if ((thetaMsAp) || (kinematics == false))
         theta0 = .001; // 1 mrad 
     else
-    {
-        theta0 = (13.6 * MeV) / (incomingTrack->GetBeta() * c * incomingTrack->GetMomentum());
-        theta0 = theta0 * zMat * TMath::Sqrt(x / xr) * (1 + 0.038 * TMath::Log(x / xr));
-    }
-
-    Double_t phiP = rndEngine->Rndm() * 2*pi;
-    Double_t thetaP = rndEngine->Gaus(0., theta0);
+        theta0 = HighlandTheta0(incomingTrack->GetBeta(), incomingTrack->GetMomentum(), highlandConstant);
 
     Double_t momentumNorm = TMath::Sqrt(ipx*ipx + ipy*ipy + ipz*ipz);
 
-    Double_t cd[3];
-
-    /*
-    x = sin(theta) * cos(phi)
-    y = sin(theta) * sin(phi)
-    z = cos(theta)
-    */
-
-    Double_t theta = TMath::ACos(ipz / momentumNorm);
-    Double_t phi = TMath::ACos((ipx / momentumNorm) / TMath::Sin(theta));
-    if(ipy < 0) phi = 2*TMath::Pi() - phi;
-
-    Rotate(theta, phi, thetaP, phiP, cd);
+    Double_t cd[3] = {ipx / momentumNorm, ipy / momentumNorm, ipz / momentumNorm};
+    if (random != nullptr)
+        ScatterDirection(cd[0], cd[1], cd[2], theta0, random);
+    else
+        ScatterDirection(cd[0], cd[1], cd[2], theta0, rndEngine);
 
     opx = momentumNorm * cd[0];
     opy = momentumNorm * cd[1];
@@ -96,6 +82,132 @@ void TransportEngine::MultipleScattering(Track * incomingTrack, Track * &outgoin
     //std::cerr << "\nCalled multiple scattering from " << incomingTrack << " to " << outgoingTrack << " ";
 }
 
+void TransportEngine::RotateDirection(Double_t &dx, Double_t &dy, Double_t &dz, Double_t thp, Double_t php)
+{
+    /*
+    Same rotation of Rotate, with the local frame built from the direction itself:
+    sin(theta) = sqrt(dx^2 + dy^2), cos(phi) = dx / sin(theta), sin(phi) = dy / sin(theta)
+    e1 = (-sin(phi), cos(phi), 0)
+    e2 = (-cos(theta) cos(phi), -cos(theta) sin(phi), sin(theta))
+    */
+    //A single sincos evaluation for the azimuth, the scattering angle is small and uses the series
+    Double_t sinThp, cosThp, sinPhp, cosPhp;
+    FastMath::SinCosSmall(thp, sinThp, cosThp);
+    FastMath::SinCos(php, sinPhp, cosPhp);
+
+    Double_t a = sinThp * cosPhp; //Component along e1
+    Double_t b = sinThp * sinPhp; //Component along e2
+
+    Double_t st = TMath::Sqrt(dx*dx + dy*dy);
+    if (st < 1e-12)
+    {
+        //Direction along the beam axis: phi = 0 as in Rotate with theta = 0
+        dx = -dz * b;
+        dy = a;
+        dz = dz * cosThp;
+        return;
+    }
+
+    Double_t cp = dx / st;
+    Double_t sp = dy / st;
+
+    Double_t ox = -sp * a - dz * cp * b + dx * cosThp;
+    Double_t oy =  cp * a - dz * sp * b + dy * cosThp;
+    Double_t oz =            st * b     + dz * cosThp;
+
+    dx = ox;
+    dy = oy;
+    dz = oz;
+}
+
+void TransportEngine::RotateDirectionAngles(Double_t &dx, Double_t &dy, Double_t &dz, Double_t thetaP, Double_t phiP)
+{
+    Double_t cd[3];
+
+    /*
+    x = sin(theta) * cos(phi)
+    y = sin(theta) * sin(phi)
+    z = cos(theta)
+    */
+
+    Double_t theta = TMath::ACos(dz);
+    Double_t phi = TMath::ACos(dx / TMath::Sin(theta));
+    if(dy < 0) phi = 2*TMath::Pi() - phi;
+
+    Rotate(theta, phi, thetaP, phiP, cd);
+
+    dx = cd[0];
+    dy = cd[1];
+    dz = cd[2];
+}
+
+bool TransportEngine::ValidateRotation(unsigned long int nSamples, Double_t theta0, RndEngine * rndE)
+{
+    if (rndE == nullptr) rndE = rndEngine;
+
+    //Polar angle of the outgoing direction and deflection angle, for the two implementations
+    TH1D hTheta("hThetaFrame", "Outgoing #theta - frame", 200, 0., TMath::Pi());
+    TH1D hThetaRef("hThetaAngles", "Outgoing #theta - angles", 200, 0., TMath::Pi());
+    TH1D hDefl("hDeflFrame", "Deflection - frame", 200, 0., 5 * theta0);
+    TH1D hDeflRef("hDeflAngles", "Deflection - angles", 200, 0., 5 * theta0);
+    hTheta.SetDirectory(nullptr);
+    hThetaRef.SetDirectory(nullptr);
+    hDefl.SetDirectory(nullptr);
+    hDeflRef.SetDirectory(nullptr);
+
+    Double_t maxDiff = 0.;
+
+    for (unsigned long int i = 0; i < nSamples; ++i)
+    {
+        //Isotropic incoming direction
+        Double_t cosT = 2 * rndE->Rndm() - 1;
+        Double_t phi = rndE->Rndm() * 2*Units::pi;
+        Double_t sinT = TMath::Sqrt(1 - cosT*cosT);
+        Double_t in[3] = {sinT * TMath::Cos(phi), sinT * TMath::Sin(phi), cosT};
+
+        Double_t phiP = rndE->Rndm() * 2*Units::pi;
+        Double_t thetaP = rndE->Gaus(0., theta0);
+
+        Double_t f[3] = {in[0], in[1], in[2]};
+        Double_t r[3] = {in[0], in[1], in[2]};
+        RotateDirection(f[0], f[1], f[2], thetaP, phiP);
+        RotateDirectionAngles(r[0], r[1], r[2], thetaP, phiP);
+
+        for (unsigned int k = 0; k < 3; ++k)
+            maxDiff = TMath::Max(maxDiff, TMath::Abs(f[k] - r[k]));
+
+        hTheta.Fill(TMath::ACos(f[2]));
+        hThetaRef.Fill(TMath::ACos(r[2]));
+        hDefl.Fill(TMath::ACos(TMath::Min(1., f[0]*in[0] + f[1]*in[1] + f[2]*in[2])));
+        hDeflRef.Fill(TMath::ACos(TMath::Min(1., r[0]*in[0] + r[1]*in[1] + r[2]*in[2])));
+    }
+
+    Double_t ksTheta = hTheta.KolmogorovTest(&hThetaRef);
+    Double_t ksDefl = hDefl.KolmogorovTest(&hDeflRef);
+
+    std::cout << "\nMultiple scattering rotation validation (" << nSamples << " samples, theta0 = " << theta0 << " rad)";
+    std::cout << "\n   Max difference of the direction components: " << maxDiff;
+    std::cout << "\n   Kolmogorov test outgoing theta: " << ksTheta << "   deflection angle: " << ksDefl << "\n";
+
+    //The reference recovers theta with ACos, which loses precision for directions close to the beam axis (differences up to ~1e-9)
+    return (maxDiff < 1e-6) && (ksTheta > 0.99) && (ksDefl > 0.99);
+}
+
+Double_t TransportEngine::HighlandTheta0(Double_t beta, Double_t momentum, Int_t zMat, Double_t x, Double_t xr)
+{
+    return HighlandTheta0(beta, momentum, HighlandConstant(zMat, x, xr));
+}
+
+Double_t TransportEngine::HighlandConstant(Int_t zMat, Double_t x, Double_t xr)
+{
+    if ((x <= 0) || (xr <= 0)) return 0.;
+
+    Double_t constant = (13.6 * Units::MeV / Units::c) * TMath::Abs(zMat) * TMath::Sqrt(x / xr) * (1 + 0.038 * TMath::Log(x / xr));
+
+    //The logarithmic correction is negative for very thin layers (x/X0 < 4e-12, e.g. vacuum)
+    return (constant > 0) ? constant : 0.;
+}
+
 void TransportEngine::Rotate(Double_t th, Double_t ph, Double_t thp, Double_t php, Double_t * cd)
 {
     Double_t mr[3][3];
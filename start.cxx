@@ -57,60 +57,104 @@ void start(TString myopt="fast", TString configurationFile = "nn")
     opt = "kgOs";
   }
 
+  //Every variant of the compiler flags is built in its own directory: ACLiC rebuilds a library only when the sources are newer, so a shared directory would load the library of the previous variant
+  TString buildDir = "build";
+
+  //Instruction set of the intersection kernels: "native" enables AVX2/AVX-512 if the CPU supports them, "scalar" disables the SIMD path
+  if(myopt.Contains("native"))
+  {
+    gSystem->SetFlagsOpt(TString(gSystem->GetFlagsOpt()) + " -march=native");
+    buildDir += "_native";
+  }
+  if(myopt.Contains("scalar"))
+  {
+    gSystem->AddIncludePath("-DTANS_SCALAR_INTERSECTION");
+    buildDir += "_scalar";
+  }
+
+  //Precision of the FastMath functions: "exactmath" uses libm (reference), "fastmath" the short polynomials
+  if(myopt.Contains("exactmath"))
+  {
+    gSystem->AddIncludePath("-DTANS_MATH_PRECISION=0");
+    buildDir += "_exactmath";
+  }
+  else if(myopt.Contains("fastmath"))
+  {
+    gSystem->AddIncludePath("-DTANS_MATH_PRECISION=2");
+    buildDir += "_fastmath";
+  }
+
+  //Single precision transport
+  if(myopt.Contains("float"))
+  {
+    gSystem->AddIncludePath("-DTANS_SINGLE_PRECISION");
+    buildDir += "_float";
+  }
+
   std::cerr << "\n";
   std::cerr << "\nSource code compilation started using ACLiC...\n";
-  gSystem->MakeDirectory("./build/");
+  gSystem->MakeDirectory("./" + buildDir + "/");
 
   std::cerr << "\nCompiling Monte Carlo simulation classes:";
 
   //Compile module ProgramConfig (with units.h header)
   std::cerr << "\n\033[1mmake conf.cpp >> conf.so\033[0m ";
-  if(gSystem->CompileMacro("./src/conf.cpp",opt.Data(), "ProgramConfig", "build") == 0)
+  if(gSystem->CompileMacro("./src/conf.cpp",opt.Data(), "ProgramConfig", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module rndEngine
   std::cerr << "\n\033[1mmake rndEngine.cpp >> rndEngine.so\033[0m ";
-  if(gSystem->CompileMacro("./src/rndEngine.cpp",opt.Data(), "RndEngine", "build") == 0)
+  if(gSystem->CompileMacro("./src/rndEngine.cpp",opt.Data(), "RndEngine", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module track
   std::cerr << "\n\033[1mmake track.cpp >> track.so\033[0m ";
-  if(gSystem->CompileMacro("./src/track.cpp",opt.Data(), "Track", "build") == 0)
+  if(gSystem->CompileMacro("./src/track.cpp",opt.Data(), "Track", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module transportEngine
   std::cerr << "\n\033[1mmake transportEngine.cpp >> transportEngine.so\033[0m ";
-  if(gSystem->CompileMacro("./src/transportEngine.cpp",opt.Data(), "TransportEngine", "build") == 0)
+  if(gSystem->CompileMacro("./src/transportEngine.cpp",opt.Data(), "TransportEngine", buildDir.Data()) == 0)
+    {std::cerr << " ERR"; return;}
+
+  //Compile module eventArena
+  std::cerr << "\n\033[1mmake eventArena.cpp >> eventArena.so\033[0m ";
+  if(gSystem->CompileMacro("./src/eventArena.cpp",opt.Data(), "EventArena", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module eventManager
   std::cerr << "\n\033[1mmake eventManager.cpp >> eventManager.so\033[0m ";
-  if(gSystem->CompileMacro("./src/eventManager.cpp",opt.Data(), "EventManager", "build") == 0)
+  if(gSystem->CompileMacro("./src/eventManager.cpp",opt.Data(), "EventManager", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module detectorEffects
   std::cerr << "\n\033[1mmake detectorEffects.cpp >> detectorEffects.so\033[0m ";
-  if(gSystem->CompileMacro("./src/detectorEffects.cpp",opt.Data(), "DetectorEffects", "build") == 0)
+  if(gSystem->CompileMacro("./src/detectorEffects.cpp",opt.Data(), "DetectorEffects", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module experimentSimulation
   std::cerr << "\n\033[1mmake experimentSimulation.cpp >> experimentSimulation.so\033[0m ";
-  if(gSystem->CompileMacro("./src/experimentSimulation.cpp",opt.Data(), "ExperimentSimulation", "build") == 0)
+  if(gSystem->CompileMacro("./src/experimentSimulation.cpp",opt.Data(), "ExperimentSimulation", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module particleGun
   std::cerr << "\n\033[1mmake particleGun.cpp >> particleGun.so\033[0m ";
-  if(gSystem->CompileMacro("./src/particleGun.cpp",opt.Data(), "ParticleGun", "build") == 0)
+  if(gSystem->CompileMacro("./src/particleGun.cpp",opt.Data(), "ParticleGun", buildDir.Data()) == 0)
+    {std::cerr << " ERR"; return;}
+
+  //Compile module outputWriter
+  std::cerr << "\n\033[1mmake outputWriter.cpp >> outputWriter.so\033[0m ";
+  if(gSystem->CompileMacro("./src/outputWriter.cpp",opt.Data(), "OutputWriter", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module runManager
   std::cerr << "\n\033[1mmake runManager.cpp >> runManager.so\033[0m ";
-  if(gSystem->CompileMacro("./src/runManager.cpp",opt.Data(), "RunManager", "build") == 0)
+  if(gSystem->CompileMacro("./src/runManager.cpp",opt.Data(), "RunManager", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module eventDisplay
   std::cerr << "\n\033[1mmake eventDisplay.cpp >> eventDisplay.so\033[0m ";
-  if(gSystem->CompileMacro("./src/eventDisplay.cpp",opt.Data(), "EventDisplay", "build") == 0)
+  if(gSystem->CompileMacro("./src/eventDisplay.cpp",opt.Data(), "EventDisplay", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   std::cerr << "\n\nCompiling reconstruction classes:";
@@ -118,28 +162,33 @@ void start(TString myopt="fast", TString configurationFile = "nn")
 
   //Compile module calculateDeltaPhiMax
   std::cerr << "\n\033[1mmake calculateDeltaPhiMax.cpp >> calculateDeltaPhiMax.so\033[0m ";
-  if(gSystem->CompileMacro("./src/calculateDeltaPhiMax.cpp",opt.Data(), "CalculateDeltaPhiMax", "build") == 0)
+  if(gSystem->CompileMacro("./src/calculateDeltaPhiMax.cpp",opt.Data(), "CalculateDeltaPhiMax", buildDir.Data()) == 0)
     std::cerr << " ERR";
 
   //Compile module hitsAnalysis
   std::cerr << "\n\033[1mmake hitsAnalysis.cpp >> hitsAnalysis.so\033[0m ";
-  if(gSystem->CompileMacro("./src/hitsAnalysis.cpp",opt.Data(), "HitsAnalysis", "build") == 0)
+  if(gSystem->CompileMacro("./src/hitsAnalysis.cpp",opt.Data(), "HitsAnalysis", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
   //Compile module resultsAnalysis
   std::cerr << "\n\033[1mmake resultsAnalysis.cpp >> resultsAnalysis.so\033[0m ";
-  if(gSystem->CompileMacro("./src/resultsAnalysis.cpp",opt.Data(), "ResultsAnalysis", "build") == 0)
+  if(gSystem->CompileMacro("./src/resultsAnalysis.cpp",opt.Data(), "ResultsAnalysis", buildDir.Data()) == 0)
     std::cerr << " ERR";
 
   //Compile module vertexReco
   std::cerr << "\n\033[1mmake vertexReco.cpp >> vertexReco.so\033[0m ";
-  if(gSystem->CompileMacro("./src/vertexReco.cpp",opt.Data(), "VertexReco", "build") == 0)
+  if(gSystem->CompileMacro("./src/vertexReco.cpp",opt.Data(), "VertexReco", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
   
   
+  //Compile module shardMerger
+  std::cerr << "\n\033[1mmake shardMerger.cpp >> shardMerger.so\033[0m ";
+  if(gSystem->CompileMacro("./src/shardMerger.cpp",opt.Data(), "ShardMerger", buildDir.Data()) == 0)
+    {std::cerr << " ERR"; return;}
+
   //Compile module Cli
   std::cerr << "\n\033[1mmake cli.cpp >> cli.so\033[0m ";
-  if(gSystem->CompileMacro("./src/cli.cpp",opt.Data(), "Cli", "build") == 0)
+  if(gSystem->CompileMacro("./src/cli.cpp",opt.Data(), "Cli", buildDir.Data()) == 0)
     {std::cerr << " ERR"; return;}
 
     